@@ -0,0 +1,329 @@
+// flatova
+#include <fl_application.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BenchConfig {
+    uint32_t frames  = 1000;
+    uint32_t warmup  = 60; // frames drawn before measuring, lets clocks and caches settle
+    uint32_t width   = 1000;
+    uint32_t height  = 800;
+    bool     windowed = false;
+    bool     pipeline_stats = false;
+    bool     serial_recording = false;
+    bool     sync_compute     = false;
+    bool     fence_sync       = false;
+    bool     low_latency      = false;
+    bool     render_pass      = false;
+    bool     depth            = false;
+    uint32_t frames_in_flight = fl::DEFAULT_FRAMES_IN_FLIGHT;
+    uint32_t swap_images      = 0; // 0 leaves the choice to the engine
+    double   target_fps       = 0.0;
+
+    fl::PresentPolicy present_policy = fl::PresentPolicy::MAILBOX;
+    std::string       present_name   = "mailbox";
+
+    fl::SceneConfig scene{};
+
+    std::string out_path = "frame_bench.json";
+};
+
+struct Summary {
+    double mean = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+    size_t samples = 0;
+};
+
+// gpu results of a single named pass accumulated over every measured frame
+struct PassSamples {
+    std::vector<double> gpu_ms{};
+
+    size_t   stats_samples        = 0;
+    uint64_t input_vertices       = 0;
+    uint64_t input_primitives     = 0;
+    uint64_t vertex_invocations   = 0;
+    uint64_t clipping_primitives  = 0;
+    uint64_t fragment_invocations = 0;
+};
+
+static bool parse_present_policy(const char *name, fl::PresentPolicy *policy_ptr) {
+    static const std::map<std::string, fl::PresentPolicy> policies {
+        { "fifo",         fl::PresentPolicy::FIFO },
+        { "fifo-relaxed", fl::PresentPolicy::FIFO_RELAXED },
+        { "mailbox",      fl::PresentPolicy::MAILBOX },
+        { "immediate",    fl::PresentPolicy::IMMEDIATE }
+    };
+
+    auto found = policies.find(name);
+
+    if(found == policies.end())
+        return false;
+
+    *policy_ptr = found->second;
+    return true;
+}
+
+static bool parse_args(int argc, char **argv, BenchConfig *config_ptr) {
+    for(int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if(strcmp(arg, "--windowed") == 0)
+            config_ptr->windowed = true;
+        else if(strcmp(arg, "--pipeline-stats") == 0)
+            config_ptr->pipeline_stats = true;
+        else if(strcmp(arg, "--serial-recording") == 0)
+            config_ptr->serial_recording = true;
+        else if(strcmp(arg, "--sync-compute") == 0)
+            config_ptr->sync_compute = true;
+        else if(strcmp(arg, "--fence-sync") == 0)
+            config_ptr->fence_sync = true;
+        else if(strcmp(arg, "--render-pass") == 0)
+            config_ptr->render_pass = true;
+        else if(strcmp(arg, "--depth") == 0)
+            config_ptr->depth = true;
+        else if(strcmp(arg, "--low-latency") == 0)
+            config_ptr->low_latency = true;
+        else if(strcmp(arg, "--gpu-culling") == 0)
+            config_ptr->scene.gpu_culling = true;
+        else if(strcmp(arg, "--frames") == 0 && has_value)
+            config_ptr->frames = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--warmup") == 0 && has_value)
+            config_ptr->warmup = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--width") == 0 && has_value)
+            config_ptr->width = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--height") == 0 && has_value)
+            config_ptr->height = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--frames-in-flight") == 0 && has_value)
+            config_ptr->frames_in_flight = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--swap-images") == 0 && has_value)
+            config_ptr->swap_images = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--target-fps") == 0 && has_value)
+            config_ptr->target_fps = atof(argv[++i]);
+        else if(strcmp(arg, "--present-mode") == 0 && has_value &&
+                parse_present_policy(argv[i + 1], &config_ptr->present_policy))
+            config_ptr->present_name = argv[++i];
+        else if(strcmp(arg, "--draws") == 0 && has_value)
+            config_ptr->scene.draw_count = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--instances") == 0 && has_value)
+            config_ptr->scene.instance_count = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--sprites") == 0 && has_value)
+            config_ptr->scene.sprite_count = static_cast<uint32_t>(atoi(argv[++i]));
+        else if(strcmp(arg, "--out") == 0 && has_value)
+            config_ptr->out_path = argv[++i];
+        else {
+            spdlog::error("unknown or incomplete argument \"{}\"", arg);
+            return false;
+        }
+    }
+
+    return config_ptr->frames > 0 && config_ptr->frames_in_flight > 0;
+}
+
+// nearest rank percentile over an already sorted sample set
+static double percentile(const std::vector<double> &sorted, double pct) {
+    size_t rank = static_cast<size_t>(pct / 100.0 * static_cast<double>(sorted.size()) + 0.5);
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+
+    return sorted[rank - 1];
+}
+
+static Summary summarize(std::vector<double> samples) {
+    Summary summary{};
+    summary.samples = samples.size();
+
+    if(samples.empty())
+        return summary;
+
+    std::sort(samples.begin(), samples.end());
+
+    double total = 0.0;
+    for(double sample : samples)
+        total += sample;
+
+    summary.mean = total / static_cast<double>(samples.size());
+    summary.p50  = percentile(samples, 50.0);
+    summary.p95  = percentile(samples, 95.0);
+    summary.p99  = percentile(samples, 99.0);
+    summary.max  = samples.back();
+
+    return summary;
+}
+
+static void write_summary(FILE *file, const char *name, const Summary &summary, bool last) {
+    fprintf(file,
+        "  \"%s\": { \"samples\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+        name, summary.samples, summary.mean, summary.p50, summary.p95, summary.p99, summary.max,
+        last ? "" : ",");
+}
+
+static void write_passes(FILE *file, const std::map<std::string, PassSamples> &passes) {
+    fprintf(file, "  \"passes\": [\n");
+
+    size_t written = 0;
+
+    for(const auto &[name, samples] : passes) {
+        Summary summary = summarize(samples.gpu_ms);
+        double stats_count = samples.stats_samples > 0 ? static_cast<double>(samples.stats_samples) : 1.0;
+
+        fprintf(file,
+            "    { \"name\": \"%s\", \"gpu_ms\": { \"samples\": %zu, \"mean\": %.4f, \"p50\": %.4f, "
+            "\"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+            name.c_str(), summary.samples, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+
+        // averages per frame, high vertex counts against few fragments point at a vertex bound pass
+        if(samples.stats_samples > 0)
+            fprintf(file,
+                ", \"pipeline_stats\": { \"samples\": %zu, \"input_vertices\": %.1f, \"input_primitives\": %.1f, "
+                "\"vertex_invocations\": %.1f, \"clipping_primitives\": %.1f, \"fragment_invocations\": %.1f }",
+                samples.stats_samples,
+                samples.input_vertices / stats_count, samples.input_primitives / stats_count,
+                samples.vertex_invocations / stats_count, samples.clipping_primitives / stats_count,
+                samples.fragment_invocations / stats_count);
+
+        fprintf(file, " }%s\n", ++written == passes.size() ? "" : ",");
+    }
+
+    fprintf(file, "  ],\n");
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config{};
+
+    if(parse_args(argc, argv, &config) == false) {
+        spdlog::error("usage: flatova_bench [--frames N] [--warmup N] [--width N] [--height N] "
+                      "[--draws N] [--instances N] [--sprites N] [--windowed] [--pipeline-stats] [--serial-recording] "
+                      "[--gpu-culling] [--sync-compute] [--fence-sync] [--frames-in-flight N] [--swap-images N] "
+                      "[--low-latency] [--render-pass] [--depth] [--present-mode fifo|fifo-relaxed|mailbox|immediate] [--target-fps N] "
+                      "[--out path]");
+        return EXIT_FAILURE;
+    }
+
+    fl::Application app {
+        static_cast<int>(config.width), static_cast<int>(config.height), "Flatova Bench", !config.windowed
+    };
+
+    app.set_pipeline_statistics(config.pipeline_stats);
+    app.set_parallel_recording(config.serial_recording == false);
+    app.set_async_compute(config.sync_compute == false);
+    app.set_timeline_semaphores(config.fence_sync == false);
+    app.set_frames_in_flight(config.frames_in_flight);
+    app.set_swap_chain_img_count(config.swap_images);
+    app.set_low_latency(config.low_latency);
+    app.set_present_policy(config.present_policy);
+    app.set_target_fps(config.target_fps);
+    app.set_dynamic_rendering(config.render_pass == false);
+    app.set_depth_buffer(config.depth);
+    app.init();
+    app.set_scene(config.scene);
+
+    if(app.run_frames(config.warmup) == false) {
+        spdlog::error("warmup frames failed");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<double> cpu_ms{}, fence_ms{}, acquire_ms{}, latency_ms{}, jitter_ms{}, gpu_ms{};
+    std::map<std::string, PassSamples> passes{};
+    cpu_ms.reserve(config.frames);
+    fence_ms.reserve(config.frames);
+    acquire_ms.reserve(config.frames);
+    latency_ms.reserve(config.frames);
+    jitter_ms.reserve(config.frames);
+    gpu_ms.reserve(config.frames);
+
+    bool success = app.run_frames(config.frames, [&](const fl::FrameStats &stats) {
+        cpu_ms.push_back(stats.cpu_frame_ms);
+        fence_ms.push_back(stats.fence_wait_ms);
+        acquire_ms.push_back(stats.acquire_ms);
+        latency_ms.push_back(stats.latency_wait_ms);
+        jitter_ms.push_back(stats.pacing_jitter_ms);
+
+        if(stats.gpu_valid == false)
+            return;
+
+        gpu_ms.push_back(stats.gpu_ms);
+
+        for(const fl::GpuPassStats &pass : *app.get_gpu_pass_stats_ptr()) {
+            PassSamples &samples = passes[pass.name];
+            samples.gpu_ms.push_back(pass.gpu_ms);
+
+            if(pass.has_pipeline_stats == false)
+                continue;
+
+            samples.stats_samples++;
+            samples.input_vertices       += pass.input_vertices;
+            samples.input_primitives     += pass.input_primitives;
+            samples.vertex_invocations   += pass.vertex_invocations;
+            samples.clipping_primitives  += pass.clipping_primitives;
+            samples.fragment_invocations += pass.fragment_invocations;
+        }
+    });
+
+    if(success == false) {
+        spdlog::error("benchmark frames failed");
+        return EXIT_FAILURE;
+    }
+
+    Summary cpu_summary     = summarize(cpu_ms);
+    Summary fence_summary   = summarize(fence_ms);
+    Summary acquire_summary = summarize(acquire_ms);
+    Summary latency_summary = summarize(latency_ms);
+    Summary jitter_summary  = summarize(jitter_ms);
+    Summary gpu_summary     = summarize(gpu_ms);
+
+    spdlog::info("cpu frame ms  p50 {:.3f} p95 {:.3f} p99 {:.3f}", cpu_summary.p50, cpu_summary.p95, cpu_summary.p99);
+    spdlog::info("fence wait ms p50 {:.3f} p95 {:.3f} p99 {:.3f}", fence_summary.p50, fence_summary.p95, fence_summary.p99);
+    spdlog::info("acquire ms    p50 {:.3f} p95 {:.3f} p99 {:.3f}", acquire_summary.p50, acquire_summary.p95, acquire_summary.p99);
+    if(config.low_latency)
+        spdlog::info("latency ms    p50 {:.3f} p95 {:.3f} p99 {:.3f}", latency_summary.p50, latency_summary.p95, latency_summary.p99);
+    if(config.target_fps > 0.0)
+        spdlog::info("pacing jitter p50 {:.3f} p95 {:.3f} p99 {:.3f}", jitter_summary.p50, jitter_summary.p95, jitter_summary.p99);
+    spdlog::info("gpu ms        p50 {:.3f} p95 {:.3f} p99 {:.3f}", gpu_summary.p50, gpu_summary.p95, gpu_summary.p99);
+
+    FILE *file = fopen(config.out_path.c_str(), "w");
+
+    if(file == nullptr) {
+        spdlog::error("cannot open \"{}\" for writing", config.out_path);
+        return EXIT_FAILURE;
+    }
+
+    // the surface may lack the requested mode, the swap chain then fell back towards fifo
+    const char *present_mode = config.windowed ? fl::get_present_mode_name(app.get_present_mode()) : "none";
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %u,\n", config.frames);
+    fprintf(file, "  \"warmup\": %u,\n", config.warmup);
+    fprintf(file, "  \"scene\": { \"width\": %u, \"height\": %u, \"draws\": %u, \"instances\": %u, \"sprites\": %u, "
+            "\"headless\": %s, \"parallel_recording\": %s, \"gpu_culling\": %s, "
+            "\"async_compute\": %s, \"timeline_semaphores\": %s, \"frames_in_flight\": %u, \"swap_images\": %u, "
+            "\"low_latency\": %s, \"present_policy\": \"%s\", \"present_mode\": \"%s\", \"target_fps\": %.2f, "
+            "\"dynamic_rendering\": %s, \"depth\": %s },\n",
+            config.width, config.height, config.scene.draw_count, config.scene.instance_count, config.scene.sprite_count,
+            config.windowed ? "false" : "true", app.is_parallel_recording() ? "true" : "false",
+            app.is_gpu_culling() ? "true" : "false", app.is_async_compute() ? "true" : "false",
+            app.is_timeline_sync() ? "true" : "false", config.frames_in_flight, config.swap_images,
+            config.low_latency ? "true" : "false", config.present_name.c_str(), present_mode,
+            config.target_fps,
+            app.is_dynamic_rendering() ? "true" : "false", app.has_depth_buffer() ? "true" : "false");
+    write_summary(file, "cpu_frame_ms", cpu_summary, false);
+    write_summary(file, "fence_wait_ms", fence_summary, false);
+    write_summary(file, "acquire_ms", acquire_summary, false);
+    write_summary(file, "latency_wait_ms", latency_summary, false);
+    write_summary(file, "pacing_jitter_ms", jitter_summary, false);
+    write_passes(file, passes);
+    write_summary(file, "gpu_ms", gpu_summary, true);
+    fprintf(file, "}\n");
+
+    fclose(file);
+
+    spdlog::info("wrote benchmark results to {}", config.out_path);
+
+    return EXIT_SUCCESS;
+}
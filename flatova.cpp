@@ -4,12 +4,23 @@
 // flatova
 #include <fl_application.hpp>
 
-int main(void) {
+#include <cstdlib>
+#include <cstring>
+
+// amount of frames rendered when running with --headless
+#define HEADLESS_FRAME_COUNT 1000
+
+int main(int argc, char **argv) {
+    bool headless = argc > 1 && strcmp(argv[1], "--headless") == 0;
+
     fl::Application app {
-        1000, 800, "Flatova"
+        1000, 800, "Flatova", headless
     };
 
     app.init();
 
+    if(headless)
+        return app.run_frames(HEADLESS_FRAME_COUNT) ? EXIT_SUCCESS : EXIT_FAILURE;
+
     return app.run();
 }
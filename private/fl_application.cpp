@@ -1,16 +1,30 @@
 #include <fl_application.hpp>
+#include <fl_mesh_builder.hpp>
+#include <fl_vulkan_utils.hpp>
 
 #include <spdlog/spdlog.h>
 
 #include <cstring>
+#include <chrono>
+#include <cmath>
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_core.h>
 
 namespace fl {
 
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+Application::Application(int width, int height, const std::string &name, bool headless)
+    : _width(width), _height(height), _name(name), _headless(headless), _win_ptr(nullptr),
+      _vk_core(_enable_validation_layers) {
 
-Application::Application(int width, int height, const std::string &name)
-    : _width(width), _height(height), _name(name), _win_ptr(nullptr), _vk_core(_enable_validation_layers) {
+    if(_headless) {
+        spdlog::info("running headless, glfw is not initialized");
+        return;
+    }
 
     glfwInit();
 
@@ -24,32 +38,73 @@ Application::~Application() {
     VkDeviceManager *device_manager_ptr = _vk_core.get_device_manager_ptr();
     VkDevice logical = device_manager_ptr->get_logical();
 
-    for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroySemaphore(logical, _img_avail_semas[i], nullptr);
-        vkDestroySemaphore(logical, _render_fin_semas[i], nullptr);
-        vkDestroyFence(logical, _rendering_fences[i], nullptr);
-    }
+    // only what the chosen synchronization path created, the vectors of the others are empty
+    for(VkSemaphore sema : _img_avail_semas)
+        vkDestroySemaphore(logical, sema, nullptr);
+
+    for(VkSemaphore sema : _render_fin_semas)
+        vkDestroySemaphore(logical, sema, nullptr);
+
+    for(VkFence fence : _rendering_fences)
+        vkDestroyFence(logical, fence, nullptr);
+
+    _graphics_timeline.destroy();
 
+    // old swap chains and their views still waiting on frames that are done by now
+    _render_graph.destroy();
+    _deletion_queue.destroy();
     destroy_views_and_frame_buffers();
 
-    vkDestroyBuffer(logical, _vertex_buf, nullptr);
-    vkFreeMemory(logical, _vertex_buf_mem, nullptr);
+    _gpu_profiler.destroy();
+    _parallel_recorder.destroy();
+    _compute_queue.destroy();
+    _sprite_batcher.destroy();
+    _bindless_heap.destroy();
+    _uniform_ring.destroy();
+
+    // saves whatever the driver compiled this run for the next launch
+    _pipeline_cache.destroy();
+    _shader_library.destroy();
+    _layout_cache.destroy();
+
+    // waits for uploads still in flight, so the buffers below are no longer in use
+    _upload_service.destroy();
+
+    _quad_mesh.destroy();
+    _sprite_texture.destroy();
+    _gpu_culler.destroy();
 
     vkDestroyRenderPass(logical, _render_pass, nullptr);
-    vkDestroyCommandPool(logical, _cmd_pool, nullptr);
-    glfwDestroyWindow(_win_ptr);
-    glfwTerminate();
+    _frame_context.destroy();
+
+    if(_headless == false) {
+        glfwDestroyWindow(_win_ptr);
+        glfwTerminate();
+    }
 
     spdlog::info("Clean up");
 }
 
 void Application::init() {
-    init_glfw_window();
+    _thread_pool.init();
 
-    _vk_core.init(_name, _win_ptr);
-    _vk_core.get_swap_chain_ptr()->get_images(&_swpchn_imgs);
-    
-    spdlog::info("got {} amount of swap chain images!", _swpchn_imgs.size());
+    if(_headless) {
+        VkExtent2D extent { static_cast<uint32_t>(_width), static_cast<uint32_t>(_height) };
+
+        // one offscreen image per frame in flight, so frames never render into an image still in use
+        _vk_core.init_headless(_name, extent, _frames_in_flight);
+        _vk_core.get_offscreen_target_ptr()->get_images(&_swpchn_imgs);
+
+        spdlog::info("got {} amount of offscreen images!", _swpchn_imgs.size());
+    }
+    else {
+        init_glfw_window();
+
+        _vk_core.init(_name, _win_ptr);
+        _vk_core.get_swap_chain_ptr()->get_images(&_swpchn_imgs);
+
+        spdlog::info("got {} amount of swap chain images!", _swpchn_imgs.size());
+    }
 
     if(setup_swap_chain_views())
         spdlog::info("Setup swap chain image views success!");
@@ -59,7 +114,18 @@ void Application::init() {
     Swapchain *swpchn_ptr = _vk_core.get_swap_chain_ptr();
     VkDevice logical_device = _vk_core.get_device_manager_ptr()->get_logical();
 
-    if(setup_render_pass(swpchn_ptr, logical_device))
+    // the render pass and the pipelines are both built around the depth attachment
+    if(_enable_depth) {
+        if(find_depth_format(_vk_core.get_device_manager_ptr()->get_physical(), &_depth_format))
+            spdlog::info("Setup depth buffer format success!");
+        else
+            spdlog::warn("no depth format can be rendered into, the scene is drawn without a depth buffer");
+    }
+
+    // render pass instances begin straight on the swap chain views, no render pass or frame buffers to build
+    if(setup_dynamic_rendering())
+        spdlog::info("Setup dynamic rendering success!");
+    else if(setup_render_pass(_vk_core.get_chosen_img_format(), logical_device))
         spdlog::info("Create render pass success!");
     else
         spdlog::error("Create render pass failed!");
@@ -68,46 +134,137 @@ void Application::init() {
     VkExtent2D extent = _vk_core.get_swap_chain_extent();
 
     set_viewport_extents_scissors(extent);
-    
-    if(_pipeline.init(logical_device, swpchn_ptr, _render_pass, &_viewport, &_scissor))
-        spdlog::info("Pipeline initialization complete");
+
+    if(_pipeline_cache.init(_vk_core.get_device_manager_ptr()->get_physical(), logical_device) == false)
+        spdlog::error("Setup pipeline cache failed, pipelines compile without one");
+
+    _shader_library.init(logical_device);
+    _layout_cache.init(logical_device);
+
+    if(setup_bindless_heap())
+        spdlog::info("Setup bindless heap success!");
+    else
+        spdlog::error("Setup bindless heap failed!");
+
+    if(setup_uniform_ring())
+        spdlog::info("Setup uniform ring success!");
+    else
+        spdlog::error("Setup uniform ring failed!");
+
+    _pipeline_builder.init(logical_device, &_thread_pool, &_shader_library, &_layout_cache,
+                           _pipeline_cache.get_raw_handle());
+
+    auto pipeline_start = std::chrono::steady_clock::now();
+
+    PipelineBuildInfo pipeline_info{};
+    pipeline_info.pipeline_ptr   = &_pipeline;
+    pipeline_info.swap_chain_ptr = swpchn_ptr;
+    pipeline_info.render_pass    = _render_pass;
+    pipeline_info.color_format   = _vk_core.get_chosen_img_format();
+    pipeline_info.depth_format   = _depth_format;
+    pipeline_info.depth_test     = true;
+    pipeline_info.viewport_ptr   = &_viewport;
+    pipeline_info.scissor_ptr    = &_scissor;
+
+    std::shared_future<bool> main_built = _pipeline_builder.build(pipeline_info);
+
+    // sprites are drawn after the opaque queue and on top of it
+    pipeline_info.pipeline_ptr = _bindless_available ? &_bindless_sprite_pipeline : &_sprite_pipeline;
+    pipeline_info.depth_test   = false;
+    std::shared_future<bool> sprite_built = _pipeline_builder.build(pipeline_info);
+
+    // every pipeline compiles in parallel, the rest of init only needs them once recording starts
+    _pipeline_builder.wait_all();
+
+    if(main_built.get())
+        spdlog::info("Pipeline initialization complete in {:.2f} ms", elapsed_ms(pipeline_start));
     else
         spdlog::error("Pipeline initialization failed");
 
-    _swpchn_frame_buffers.resize(_swpchn_views.size());
+    _sprites_available = sprite_built.get();
+
+    if(_sprites_available == false)
+        spdlog::warn("sprite pipeline unavailable, run vendor/shaders/compile.sh to build the sprite shaders");
 
-    if(setup_swap_chain_frame_buffers())
-        spdlog::info("setup swap chain frame buffers success");
+    // saved right away, so a crash later on still keeps the compiled pipelines
+    _pipeline_cache.save();
+
+
+    if(setup_frame_context())
+        spdlog::info("Setup frame context success!");
+    else
+        spdlog::error("Setup frame context failed!");
+
+    if(_deletion_queue.init(_frames_in_flight))
+        spdlog::info("Setup deletion queue success!");
+    else
+        spdlog::error("Setup deletion queue failed!");
+
+    // decided up front, every queue submitting frame work tracks it the same way
+    _use_timeline = _enable_timeline && _vk_core.get_device_features_ptr()->timeline_semaphore;
+
+    if(setup_upload_service())
+        spdlog::info("Setup upload service success!");
     else
-        spdlog::error("Failed to setup swapchain frame buffers");
+        spdlog::error("Setup upload service failed!");
 
+    if(setup_compute_queue())
+        spdlog::info("Setup {} compute success!", _async_compute ? "async" : "graphics queue");
+    else
+        spdlog::error("Setup async compute queue failed!");
+
+    // only staged here, the copy is submitted together with the first frame
+    if(setup_quad_mesh())
+        spdlog::info("Setup quad mesh success!");
+    else
+        spdlog::error("Setup quad mesh failed!");
+
+    fill_opaque_queue();
+
+    if(setup_sprite_texture())
+        spdlog::info("Setup sprite texture success!");
+    else
+        spdlog::error("Setup sprite texture failed!");
 
-    if(setup_command_pool())
-        spdlog::info("Create command pool success!");
+    if(setup_gpu_culler())
+        spdlog::info("Setup gpu culler success!");
     else
-        spdlog::error("create command pool failed!");
+        spdlog::warn("gpu culler unavailable, run vendor/shaders/compile.sh to build the culling shader");
 
-    // TODO: wrap the allocation, creation of a vertex buffer and their respective memory
-    // so that its more easier to handle
-    if(setup_vertex_buffer())
-        spdlog::info("Create vertex buffer success!");
+    VkPhysicalDevice physical_device = _vk_core.get_device_manager_ptr()->get_physical();
+    uint32_t graphics_family = _vk_core.get_queue_family_idxs_ptr()->graphics.value();
+
+    if(_gpu_profiler.init(physical_device, logical_device, graphics_family, _frames_in_flight,
+                          _enable_pipeline_stats))
+        spdlog::info("Setup gpu profiler success!");
     else
-        spdlog::error("create vertex buffer failed!");
+        spdlog::error("Setup gpu profiler failed!");
 
-    if(alloc_bind_vertex_buffer_mem())
-        spdlog::info("Alloc vertex buffer success!");
+    if(_sprite_batcher.init(logical_device, _vk_core.get_allocator_ptr(), _frames_in_flight,
+                            _bindless_available ? &_bindless_heap : nullptr))
+        spdlog::info("Setup sprite batcher success!");
     else
-        spdlog::error("Alloc vertex buffer failed!");
+        spdlog::error("Setup sprite batcher failed!");
 
-    if(setup_command_buffers())
-        spdlog::info("Create command buffers success!");
+    if(setup_parallel_recording())
+        spdlog::info("Setup {} command recording success!", _parallel_recording ? "parallel" : "inline");
     else
-        spdlog::error("create command buffers failed!");
+        spdlog::error("Setup parallel command recording failed!");
 
     if(setup_synchronize_objs())
-        spdlog::info("setup sync obj success!");
+        spdlog::info("setup {} sync obj success!", _use_timeline ? "timeline" : "fence");
     else
         spdlog::error("setup sync obj failed!");
+
+    _render_graph.init(logical_device, _vk_core.get_allocator_ptr());
+
+    // the frame buffers hold the graph's depth image, so they are created along with it
+    if(build_render_graph())
+        spdlog::info("Setup render graph and frame buffers success!");
+    else
+        spdlog::error("Setup render graph failed!");
+
+    _vk_core.get_allocator_ptr()->log_stats();
 }
 
 int Application::init_glfw_window() {
@@ -120,6 +277,11 @@ int Application::init_glfw_window() {
 }
 
 int Application::run() {
+    if(_headless) {
+        spdlog::error("run needs a window, use run_frames when headless");
+        return EXIT_FAILURE;
+    }
+
     glfwMakeContextCurrent(_win_ptr);
 
     while(!glfwWindowShouldClose(_win_ptr)) {
@@ -127,6 +289,7 @@ int Application::run() {
 
         glfwSwapBuffers(_win_ptr);
 
+        begin_frame_wait();
         glfwPollEvents();
 
         draw_frame();
@@ -144,6 +307,141 @@ int Application::run() {
     return EXIT_SUCCESS;
 }
 
+bool Application::run_frames(uint32_t frame_count, const std::function<void(const FrameStats&)> &on_frame) {
+    bool success = true;
+
+    for(uint32_t i = 0; i < frame_count && success; i++) {
+        if(_headless == false && glfwWindowShouldClose(_win_ptr))
+            break;
+
+        begin_frame_wait();
+
+        if(_headless == false)
+            glfwPollEvents();
+
+        success = draw_frame();
+
+        if(on_frame)
+            on_frame(_frame_stats);
+    }
+
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+    vkDeviceWaitIdle(logical);
+
+    return success;
+}
+
+void Application::set_scene(const SceneConfig &scene) {
+    bool had_cull_pass = _gpu_culling && _async_compute == false;
+
+    _scene = scene;
+    _gpu_culling = scene.gpu_culling && setup_scene_culling(scene);
+
+    fill_opaque_queue();
+
+    // the cull pass only exists while culling on the graphics queue
+    bool has_cull_pass = _gpu_culling && _async_compute == false;
+
+    if(has_cull_pass != had_cull_pass && build_render_graph() == false)
+        spdlog::error("rebuilding the render graph failed!");
+}
+
+bool Application::setup_scene_culling(const SceneConfig &scene) {
+    if(_gpu_culler_available == false) {
+        spdlog::warn("gpu culling unavailable, the scene is drawn with cpu recorded draws");
+        return false;
+    }
+
+    // every draw of the scene becomes an object, all of them cover the quad in the middle of the screen
+    std::vector<CullObject> objects(scene.draw_count);
+
+    for(CullObject &object : objects) {
+        object.radius = 0.71f; // the corners are at +-0.5
+        object.index_count    = _quad_mesh.get_index_count();
+        object.instance_count = scene.instance_count;
+    }
+
+    // frames still in flight cull the previous objects
+    vkDeviceWaitIdle(_vk_core.get_device_manager_ptr()->get_logical());
+
+    return _gpu_culler.set_objects(objects.data(), static_cast<uint32_t>(objects.size()));
+}
+
+void Application::set_frames_in_flight(uint32_t count) {
+    _frames_in_flight = std::max(count, 1u);
+}
+
+void Application::set_swap_chain_img_count(uint32_t count) {
+    _vk_core.set_swap_chain_img_count(count);
+}
+
+void Application::set_low_latency(bool enable) {
+    _low_latency = enable;
+}
+
+void Application::set_dynamic_rendering(bool enable) {
+    _enable_dynamic_rendering = enable;
+}
+
+void Application::set_depth_buffer(bool enable) {
+    _enable_depth = enable;
+}
+
+void Application::set_present_policy(PresentPolicy policy) {
+    _vk_core.set_present_policy(policy);
+}
+
+void Application::set_target_fps(double fps) {
+    _frame_limiter.set_target_fps(fps);
+}
+
+void Application::set_pipeline_statistics(bool enable) {
+    _enable_pipeline_stats = enable;
+}
+
+void Application::set_parallel_recording(bool enable) {
+    _enable_parallel_recording = enable;
+}
+
+void Application::set_async_compute(bool enable) {
+    _enable_async_compute = enable;
+}
+
+void Application::set_timeline_semaphores(bool enable) {
+    _enable_timeline = enable;
+}
+
+VkPresentModeKHR Application::get_present_mode() const {
+    return _vk_core.get_present_mode();
+}
+
+bool Application::is_parallel_recording() const {
+    return _parallel_recording;
+}
+
+bool Application::is_gpu_culling() const {
+    return _gpu_culling;
+}
+
+bool Application::is_async_compute() const {
+    return _async_compute;
+}
+
+bool Application::is_timeline_sync() const {
+    return _use_timeline;
+}
+
+bool Application::is_dynamic_rendering() const {
+    return _dynamic_rendering;
+}
+
+bool Application::has_depth_buffer() const {
+    return _depth_format != VK_FORMAT_UNDEFINED;
+}
+
+const std::vector<GpuPassStats>* Application::get_gpu_pass_stats_ptr() const {
+    return &_gpu_pass_stats;
+}
 
 void Application::set_viewport_extents_scissors(VkExtent2D extent) {
     _viewport.x = 0.0f;
@@ -191,19 +489,30 @@ bool Application::setup_swap_chain_views() {
 }
 
 bool Application::setup_swap_chain_frame_buffers() {
-    Swapchain *swpchn_ptr = _vk_core.get_swap_chain_ptr();
-
     VkDeviceManager *device_manager_ptr = _vk_core.get_device_manager_ptr();
     VkDevice logical = device_manager_ptr->get_logical();
 
+    // dynamic rendering draws into the views directly
+    if(_dynamic_rendering)
+        return true;
+
+    _swpchn_frame_buffers.resize(_swpchn_views.size());
+
     for(size_t i = 0; i < _swpchn_views.size(); i++) {
+        // every frame buffer shares the one depth image, frames in flight are ordered by the render graph
+        VkImageView attachments[] = { _swpchn_views[i], VK_NULL_HANDLE };
+        uint32_t attachment_count = 1;
+
+        if(_depth != INVALID_RENDER_ID)
+            attachments[attachment_count++] = _render_graph.get_view(_depth);
+
         VkFramebufferCreateInfo fb_create_info{};
         fb_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         fb_create_info.renderPass = _render_pass;
-        fb_create_info.attachmentCount = 1;
-        fb_create_info.pAttachments = &_swpchn_views[i];
+        fb_create_info.attachmentCount = attachment_count;
+        fb_create_info.pAttachments = attachments;
 
-        VkExtent2D extent = swpchn_ptr->get_img_extent();
+        VkExtent2D extent = _vk_core.get_swap_chain_extent();
 
         fb_create_info.width = extent.width;
         fb_create_info.height = extent.height;
@@ -217,10 +526,10 @@ bool Application::setup_swap_chain_frame_buffers() {
     return true;
 }
 
-bool Application::setup_render_pass(Swapchain *swap_chain_ptr, VkDevice device) {
+bool Application::setup_render_pass(VkFormat img_format, VkDevice device) {
     // define color attachment for swapchain rendering
     VkAttachmentDescription color_attach{};
-    color_attach.format  = swap_chain_ptr->get_img_format();
+    color_attach.format  = img_format;
     color_attach.samples = VK_SAMPLE_COUNT_1_BIT;
 
     color_attach.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR; // before rendering
@@ -231,8 +540,8 @@ bool Application::setup_render_pass(Swapchain *swap_chain_ptr, VkDevice device)
 
     // before render pass
     color_attach.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    // after render pass
-    color_attach.finalLayout   = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // images need to be transitioned into specific layouts
+    // after render pass, the render graph transitions it on to be presented or copied out
+    color_attach.finalLayout   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 
     VkAttachmentReference color_attach_ref{};
@@ -240,11 +549,33 @@ bool Application::setup_render_pass(Swapchain *swap_chain_ptr, VkDevice device)
     color_attach_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 
+    // only needed while the pass runs, cleared up front and never written back
+    VkAttachmentDescription depth_attach{};
+    depth_attach.format  = _depth_format;
+    depth_attach.samples = VK_SAMPLE_COUNT_1_BIT;
+
+    depth_attach.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depth_attach.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+    depth_attach.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depth_attach.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+    depth_attach.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depth_attach.finalLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depth_attach_ref{};
+    depth_attach_ref.attachment = 1;
+    depth_attach_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    bool has_depth = _depth_format != VK_FORMAT_UNDEFINED;
+
+
     // create basic triangle subpass
     VkSubpassDescription sub_pass{};
     sub_pass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     sub_pass.colorAttachmentCount = 1;
     sub_pass.pColorAttachments = &color_attach_ref; // direct reference of layout(location = 0) out vec4 outColor fragment shader!
+    sub_pass.pDepthStencilAttachment = has_depth ? &depth_attach_ref : nullptr;
 
     VkSubpassDependency dep{};
     dep.srcSubpass = VK_SUBPASS_EXTERNAL;
@@ -256,14 +587,23 @@ bool Application::setup_render_pass(Swapchain *swap_chain_ptr, VkDevice device)
     dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+    // the previous frame's depth tests have to finish before the clear
+    if(has_depth) {
+        dep.srcStageMask  |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dep.dstStageMask  |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dep.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    }
+
 
     VkRenderPassCreateInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &sub_pass;
 
-    render_pass_info.attachmentCount = 1;
-    render_pass_info.pAttachments = &color_attach;
+    VkAttachmentDescription attachments[] = { color_attach, depth_attach };
+
+    render_pass_info.attachmentCount = has_depth ? 2 : 1;
+    render_pass_info.pAttachments = attachments;
 
     render_pass_info.dependencyCount = 1;
     render_pass_info.pDependencies = &dep;
@@ -271,135 +611,562 @@ bool Application::setup_render_pass(Swapchain *swap_chain_ptr, VkDevice device)
     return vkCreateRenderPass(device, &render_pass_info, nullptr, &_render_pass) == VK_SUCCESS;
 }
 
-bool Application::setup_command_pool() {
-    const QueueFamilyIdxs *idxs_ptr = _vk_core.get_queue_family_idxs_ptr();
-    VkDevice logical_device = _vk_core.get_device_manager_ptr()->get_logical();
+bool Application::setup_dynamic_rendering() {
+    if(_enable_dynamic_rendering == false || _vk_core.get_device_features_ptr()->dynamic_rendering == false)
+        return false;
 
-    VkCommandPoolCreateInfo create_info{};
-    create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // we want to render many times, so we will clear and rerecord over it
-    create_info.queueFamilyIndex = idxs_ptr->graphics.value();
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+
+    _cmd_begin_rendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+        vkGetDeviceProcAddr(logical, "vkCmdBeginRenderingKHR"));
+    _cmd_end_rendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+        vkGetDeviceProcAddr(logical, "vkCmdEndRenderingKHR"));
 
-    return vkCreateCommandPool(logical_device, &create_info, nullptr, &_cmd_pool) == VK_SUCCESS;
+    if(_cmd_begin_rendering == nullptr || _cmd_end_rendering == nullptr) {
+        spdlog::warn("dynamic rendering entry points are missing, falling back to a render pass");
+        return false;
+    }
+
+    _dynamic_rendering = true;
+
+    return true;
 }
 
-// TODO: GPU mem alloc type
-bool Application::find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags props, uint32_t *mem_type_ptr) {
-    VkPhysicalDevice physical = _vk_core.get_device_manager_ptr()->get_physical();
+bool Application::setup_frame_context() {
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+    uint32_t graphics_family = _vk_core.get_queue_family_idxs_ptr()->graphics.value();
 
-    VkPhysicalDeviceMemoryProperties mem_props{};
-    vkGetPhysicalDeviceMemoryProperties(physical, &mem_props);
+    return _frame_context.init(logical, graphics_family, _frames_in_flight);
+}
 
-    for(uint32_t i = 0; mem_props.memoryTypeCount; i++) {
-        if(type_filter & (1 << i) && (mem_props.memoryTypes[i].propertyFlags & props) == props) {
-            *mem_type_ptr = i;
-            
-            return true;
-        }
-    }
+bool Application::setup_upload_service() {
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+    uint32_t graphics_family = _vk_core.get_queue_family_idxs_ptr()->graphics.value();
 
-    return false;
+    return _upload_service.init(logical, _vk_core.get_allocator_ptr(), _vk_core.get_transfer_queue_family(),
+                                _vk_core.get_transfer_queue_ref(), graphics_family);
 }
 
-bool Application::setup_vertex_buffer() {
+bool Application::setup_compute_queue() {
+    if(_enable_async_compute == false || _vk_core.has_async_compute() == false)
+        return true;
+
     VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+    uint32_t compute_family = _vk_core.get_compute_queue_family();
+
+    if(_compute_queue.init(logical, compute_family, _vk_core.get_compute_queue_ref(), _frames_in_flight,
+                           _use_timeline) == false)
+        return false;
 
-    VkBufferCreateInfo buf_info{};
-    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buf_info.size = sizeof(_verticies[0]) * _verticies.size();
-    buf_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    // the compute queue reads uploaded buffers and writes ones the graphics queue reads, without ownership transfers
+    _upload_service.add_sharing_family(compute_family);
+    _async_compute = true;
 
-    return vkCreateBuffer(logical, &buf_info, nullptr, &_vertex_buf) == VK_SUCCESS;
+    return true;
 }
 
-bool Application::alloc_bind_vertex_buffer_mem() {
+bool Application::setup_quad_mesh() {
+    MeshBuilder<Vertex> builder{};
+
+    for(size_t i = 0; i + 2 < _verticies.size(); i += 3)
+        builder.add_triangle(_verticies[i], _verticies[i + 1], _verticies[i + 2]);
+
+    std::vector<Vertex>   vertices{};
+    std::vector<uint32_t> indices{};
+    builder.build(&vertices, &indices);
+
+    spdlog::info("quad mesh deduplicated from {} to {} vertices of {} bytes, acmr {:.2f}", _verticies.size(),
+                 vertices.size(), sizeof(Vertex),
+                 get_acmr(indices.data(), indices.size(), vertices.size()));
+
     VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
 
-    VkMemoryRequirements mem_reqs{};
-    vkGetBufferMemoryRequirements(logical, _vertex_buf, &mem_reqs);
+    // device local, the gpu no longer reads the vertices across the bus on every draw
+    return _quad_mesh.init(logical, _vk_core.get_allocator_ptr(), &_upload_service,
+                           vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(Vertex), indices);
+}
+
+bool Application::setup_bindless_heap() {
+    if(_vk_core.get_device_features_ptr()->descriptor_indexing == false) {
+        spdlog::info("no descriptor indexing, sprites are drawn untextured");
+        return true;
+    }
 
-    uint32_t mem_filter;
+    VkDeviceManager *device_manager_ptr = _vk_core.get_device_manager_ptr();
 
-    if(find_mem_type(
-        mem_reqs.memoryTypeBits,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &mem_filter
-    ) == false)
+    if(_bindless_heap.init(device_manager_ptr->get_physical(), device_manager_ptr->get_logical()) == false)
         return false;
 
-    spdlog::info("Found memory type for allocating device memory");
+    // every pipeline layout from here on has the heap at the same set, so binding it once per command buffer
+    // covers all of them
+    _layout_cache.reserve_set(BINDLESS_SET, _bindless_heap.get_raw_set_layout_handle());
+    _bindless_available = true;
+
+    return true;
+}
 
-    VkMemoryAllocateInfo mem_alloc_info{};
-    mem_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mem_alloc_info.allocationSize = mem_reqs.size;
-    mem_alloc_info.memoryTypeIndex = mem_filter;
+bool Application::setup_uniform_ring() {
+    VkDeviceManager *device_manager_ptr = _vk_core.get_device_manager_ptr();
 
-    if(vkAllocateMemory(logical, &mem_alloc_info, nullptr, &_vertex_buf_mem) != VK_SUCCESS)
+    if(_uniform_ring.init(device_manager_ptr->get_physical(), device_manager_ptr->get_logical(),
+                          _vk_core.get_allocator_ptr(), _frames_in_flight) == false)
         return false;
-    // else
 
-    vkBindBufferMemory(logical, _vertex_buf, _vertex_buf_mem, 0);
+    // dynamic offsets pick the sub range, so the set is bound once per command buffer and never rewritten
+    _layout_cache.reserve_set(UNIFORM_RING_SET, _uniform_ring.get_raw_set_layout_handle());
 
-    return false;
+    return true;
 }
 
-bool Application::setup_command_buffers() {
-    _cmd_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+bool Application::setup_gpu_culler() {
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+    const DeviceFeatures *features_ptr = _vk_core.get_device_features_ptr();
 
-    VkCommandBufferAllocateInfo alloc_info{};
-    VkDevice logical_device = _vk_core.get_device_manager_ptr()->get_logical();
+    if(_gpu_culler.init(logical, _vk_core.get_allocator_ptr(), &_upload_service, &_shader_library, &_layout_cache,
+                        _pipeline_cache.get_raw_handle(), _frames_in_flight,
+                        features_ptr->draw_indirect_count, features_ptr->multi_draw_indirect) == false)
+        return false;
+
+    _gpu_culler_available = true;
+
+    return true;
+}
+
+bool Application::setup_sprite_texture() {
+    if(_bindless_available == false)
+        return true;
 
-    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    const uint32_t size = 64;
+    const uint32_t tile = 8;
 
-    alloc_info.commandPool = _cmd_pool;
-    alloc_info.commandBufferCount = 1;
-    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    alloc_info.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+    // white and grey tiles, the sprite color tints them
+    std::vector<uint32_t> pixels(size * size);
 
-    return vkAllocateCommandBuffers(logical_device, &alloc_info, _cmd_buffers.data()) == VK_SUCCESS;
+    for(uint32_t y = 0; y < size; y++)
+        for(uint32_t x = 0; x < size; x++)
+            pixels[y * size + x] = ((x / tile + y / tile) % 2 == 0) ? 0xffffffff : 0xff808080;
+
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+
+    if(_sprite_texture.init(logical, _vk_core.get_allocator_ptr(), &_upload_service,
+                            VkExtent2D{ size, size }, pixels.data()) == false)
+        return false;
+
+    _sprite_texture_idx = _bindless_heap.add_texture(_sprite_texture.get_raw_view_handle());
+
+    return _sprite_texture_idx != INVALID_BINDLESS_IDX;
+}
+
+bool Application::setup_parallel_recording() {
+    if(_enable_parallel_recording == false)
+        return true;
+
+    VkPhysicalDeviceFeatures features{};
+    vkGetPhysicalDeviceFeatures(_vk_core.get_device_manager_ptr()->get_physical(), &features);
+
+    // the profiled pass keeps its statistics query active across vkCmdExecuteCommands
+    if(_gpu_profiler.has_pipeline_stats() && features.inheritedQueries == VK_FALSE) {
+        spdlog::info("inherited queries are not supported, recording inline to keep pipeline statistics");
+        return true;
+    }
+
+    VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+    uint32_t graphics_family = _vk_core.get_queue_family_idxs_ptr()->graphics.value();
+
+    if(_parallel_recorder.init(logical, graphics_family, &_thread_pool, _frames_in_flight) == false)
+        return false;
+
+    _parallel_recording = true;
+
+    return true;
 }
 
 bool Application::record_command_buffer(VkCommandBuffer cmd_buf, uint32_t img_idx) {
     VkCommandBufferBeginInfo info{};
     info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    info.flags = 0;
+    info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; // recorded again every time the frame comes around
     info.pInheritanceInfo = nullptr;
 
     if(vkBeginCommandBuffer(cmd_buf, &info) != VK_SUCCESS)
         return false;
-        
-    VkRenderPassBeginInfo render_info{};
-    render_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_info.renderPass  = _render_pass;
-    render_info.framebuffer = _swpchn_frame_buffers[img_idx];
-    render_info.renderArea.offset = {0, 0};
-    render_info.renderArea.extent = _vk_core.get_swap_chain_extent();
-
-    VkClearValue clear_color = {{{.0f, .0f, .0f, 1.f}}};
-    render_info.clearValueCount = 1;
-    render_info.pClearValues = &clear_color;
+
+    _gpu_profiler.begin_frame(cmd_buf, _current_frame);
+
+    // the swap chain image is the only import, everything else the passes use lives as long as the graph
+    _frame_img_idx = img_idx;
+    _render_graph.set_imported_image(_backbuffer, _swpchn_imgs[img_idx], _swpchn_views[img_idx]);
+
+    if(_render_graph.execute(cmd_buf) == false)
+        return false;
+
+    _gpu_profiler.end_frame(cmd_buf, _current_frame);
     
-    vkCmdBeginRenderPass(cmd_buf, &render_info, VK_SUBPASS_CONTENTS_INLINE);
+    return vkEndCommandBuffer(cmd_buf) == VK_SUCCESS;
+}
 
+bool Application::build_render_graph() {
+    _render_graph.clear();
+
+    // the acquire semaphore is waited on at color output, the image is presented or copied out afterwards
+    ImageState initial{};
+    initial.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    initial.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    ImageState final{};
+    final.layout = _headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    final.stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    _backbuffer = _render_graph.import_image("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, initial, &final);
+    _depth = INVALID_RENDER_ID;
+
+    // only used by the main pass, so the graph creates it as a transient attachment
+    if(_depth_format != VK_FORMAT_UNDEFINED) {
+        TransientImageDesc depth_desc{};
+        depth_desc.format = _depth_format;
+        depth_desc.extent = _vk_core.get_swap_chain_extent();
+
+        _depth = _render_graph.create_image("depth", depth_desc);
+    }
+
+    // compute cannot run inside a render pass, so the draws are culled up front unless the compute queue does it
+    if(_gpu_culling && _async_compute == false) {
+        RenderPassId cull = _render_graph.add_pass("cull", [this](VkCommandBuffer cmd_buf) {
+            _gpu_profiler.begin_pass(cmd_buf, _current_frame, "cull");
+            record_cull(cmd_buf);
+            _gpu_profiler.end_pass(cmd_buf, _current_frame);
+
+            return true;
+        });
+
+        // the culled draw buffers are synchronized by the culler itself
+        _render_graph.set_side_effects(cull);
+    }
+
+    RenderPassId main = _render_graph.add_pass("main", [this](VkCommandBuffer cmd_buf) {
+        return record_main_pass(cmd_buf, _frame_img_idx);
+    });
+
+    _render_graph.write(main, _backbuffer, ImageAccess::COLOR_ATTACHMENT);
+
+    if(_depth != INVALID_RENDER_ID)
+        _render_graph.write(main, _depth, ImageAccess::DEPTH_ATTACHMENT);
+
+    // transients of the previous build may still be used by frames in flight
+    if(_render_graph.compile(&_deletion_queue) == false)
+        return false;
+
+    // the frame buffers hold the depth view the compile just replaced
+    if(_swpchn_frame_buffers.empty() == false) {
+        VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+        std::vector<VkFramebuffer> old_frame_buffers = std::move(_swpchn_frame_buffers);
+        _swpchn_frame_buffers.clear();
+
+        _deletion_queue.retire([logical, old_frame_buffers]() {
+            for(VkFramebuffer frame_buffer : old_frame_buffers)
+                vkDestroyFramebuffer(logical, frame_buffer, nullptr);
+        });
+    }
+
+    return setup_swap_chain_frame_buffers();
+}
+
+bool Application::record_main_pass(VkCommandBuffer cmd_buf, uint32_t img_idx) {
+    // profiled passes wrap the whole render pass instance, pipeline statistics queries cannot straddle it
+    _gpu_profiler.begin_pass(cmd_buf, _current_frame, "main");
+
+    begin_main_pass(cmd_buf, img_idx, _parallel_recording);
+
+    if(_parallel_recording) {
+        VkFormat color_format = _vk_core.get_chosen_img_format();
+
+        // stands in for the render pass when rendering dynamically
+        VkCommandBufferInheritanceRenderingInfoKHR rendering_inheritance{};
+        rendering_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+        rendering_inheritance.colorAttachmentCount = 1;
+        rendering_inheritance.pColorAttachmentFormats = &color_format;
+        rendering_inheritance.depthAttachmentFormat = _depth_format;
+        rendering_inheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.pipelineStatistics = _gpu_profiler.get_pipeline_stats_flags();
+
+        if(_dynamic_rendering)
+            inheritance.pNext = &rendering_inheritance;
+        else {
+            inheritance.renderPass = _render_pass;
+            inheritance.subpass = 0;
+            inheritance.framebuffer = _swpchn_frame_buffers[img_idx];
+        }
+
+        // the culled draws are a single indirect call, there is nothing to split across workers
+        uint32_t draw_count = _gpu_culling ? 1 : _opaque_queue.get_count();
+
+        // each worker keeps its share of the queue in front to back order
+        bool recorded = _parallel_recorder.record(_current_frame, inheritance, draw_count,
+            [this](VkCommandBuffer secondary, uint32_t first, uint32_t count) {
+                record_draws(secondary, first, count);
+            }, &_secondary_cmd_bufs);
+
+        if(recorded == false || record_sprites_secondary(inheritance) == false) {
+            spdlog::error("recording secondary command buffers failed!");
+            return false;
+        }
+
+        vkCmdExecuteCommands(cmd_buf, static_cast<uint32_t>(_secondary_cmd_bufs.size()), _secondary_cmd_bufs.data());
+    }
+    else {
+        record_draws(cmd_buf, 0, _opaque_queue.get_count());
+
+        bind_frame_uniforms(cmd_buf);
+        _sprite_batcher.flush(cmd_buf);
+    }
+
+    end_main_pass(cmd_buf);
+
+    _gpu_profiler.end_pass(cmd_buf, _current_frame);
+
+    return true;
+}
+
+void Application::begin_main_pass(VkCommandBuffer cmd_buf, uint32_t img_idx, bool secondaries) {
+    VkClearValue clear_values[2]{};
+    clear_values[0].color = {{.0f, .0f, .0f, 1.f}};
+    clear_values[1].depthStencil = {1.0f, 0}; // the far plane, every layer is nearer
+
+    VkRect2D render_area{};
+    render_area.offset = {0, 0};
+    render_area.extent = _vk_core.get_swap_chain_extent();
+
+    if(_dynamic_rendering == false) {
+        VkRenderPassBeginInfo render_info{};
+        render_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_info.renderPass  = _render_pass;
+        render_info.framebuffer = _swpchn_frame_buffers[img_idx];
+        render_info.renderArea  = render_area;
+
+        render_info.clearValueCount = _depth != INVALID_RENDER_ID ? 2 : 1;
+        render_info.pClearValues = clear_values;
+
+        vkCmdBeginRenderPass(cmd_buf, &render_info,
+                             secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+        return;
+    }
+
+    // the render graph already moved the image into the attachment layout
+    VkRenderingAttachmentInfoKHR color_attach{};
+    color_attach.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    color_attach.imageView   = _swpchn_views[img_idx];
+    color_attach.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color_attach.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color_attach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color_attach.clearValue = clear_values[0];
+
+    // the render graph moved it into the attachment layout as well, it never leaves the pass
+    VkRenderingAttachmentInfoKHR depth_attach{};
+    depth_attach.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+    depth_attach.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth_attach.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depth_attach.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth_attach.clearValue = clear_values[1];
+
+    if(_depth != INVALID_RENDER_ID)
+        depth_attach.imageView = _render_graph.get_view(_depth);
+
+    VkRenderingInfoKHR rendering_info{};
+    rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    rendering_info.flags = secondaries ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+    rendering_info.renderArea = render_area;
+    rendering_info.layerCount = 1;
+    rendering_info.colorAttachmentCount = 1;
+    rendering_info.pColorAttachments = &color_attach;
+    rendering_info.pDepthAttachment = _depth != INVALID_RENDER_ID ? &depth_attach : nullptr;
+
+    _cmd_begin_rendering(cmd_buf, &rendering_info);
+}
+
+void Application::end_main_pass(VkCommandBuffer cmd_buf) {
+    if(_dynamic_rendering)
+        _cmd_end_rendering(cmd_buf);
+    else
+        vkCmdEndRenderPass(cmd_buf);
+}
+
+void Application::record_cull(VkCommandBuffer cmd_buf) {
+    // the quad is drawn straight in device coordinates, the view is the identity
+    const float view_proj[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    CullView view{};
+    get_frustum_planes(view_proj, &view);
+
+    _gpu_culler.cull(cmd_buf, _current_frame, view);
+}
+
+VkSemaphore Application::submit_async_cull(VkSemaphore upload_sema, VkPipelineStageFlags *wait_stages_ptr,
+                                           uint64_t *wait_value_ptr) {
+    VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+
+    if(_compute_queue.begin_recording(&cmd_buf) == false)
+        return VK_NULL_HANDLE;
+
+    record_cull(cmd_buf);
+
+    *wait_stages_ptr = COMPUTE_WAIT_STAGES;
+
+    // the uploaded objects are read by the cull itself, everything else uploaded by the graphics submit after it
+    if(upload_sema != VK_NULL_HANDLE) {
+        _compute_queue.add_wait(upload_sema, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        *wait_stages_ptr |= UPLOAD_WAIT_STAGES;
+    }
+
+    return _compute_queue.submit(wait_value_ptr);
+}
+
+void Application::record_draws(VkCommandBuffer cmd_buf, uint32_t first, uint32_t count) const {
+    // secondary command buffers inherit no state, so everything is bound again per buffer
     vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline.get_raw_graphics_handle());
 
     vkCmdSetViewport(cmd_buf, 0, 1, &_viewport);
     vkCmdSetScissor(cmd_buf, 0, 1, &_scissor);
 
-    #define VERTEX_INPUT_COUNT 6
-    vkCmdDraw(cmd_buf, VERTEX_INPUT_COUNT, 1, 0, 0);
+    _quad_mesh.bind(cmd_buf);
 
-    vkCmdEndRenderPass(cmd_buf);
-    
-    return vkEndCommandBuffer(cmd_buf) == VK_SUCCESS;
+    if(_gpu_culling) {
+        _gpu_culler.draw(cmd_buf, _current_frame);
+        return;
+    }
+
+    const OpaqueDraw *draws_ptr = _opaque_queue.get_draws_ptr();
+    bool layered = _depth != INVALID_RENDER_ID;
+
+    for(uint32_t i = first; i < first + count; i++) {
+        const OpaqueDraw &draw = draws_ptr[i];
+
+        // the quad sits at z 0, a depth range collapsed onto the layer moves it there without a shader change
+        if(layered) {
+            VkViewport layer = _viewport;
+            layer.minDepth = draw.depth;
+            layer.maxDepth = draw.depth;
+
+            vkCmdSetViewport(cmd_buf, 0, 1, &layer);
+        }
+
+        vkCmdDrawIndexed(cmd_buf, draw.index_count, draw.instance_count, 0, 0, 0);
+    }
+
+    // sprites recorded after the draws expect the full depth range
+    if(layered)
+        vkCmdSetViewport(cmd_buf, 0, 1, &_viewport);
 }
 
-bool Application::setup_synchronize_objs() {
-    _img_avail_semas.resize(MAX_FRAMES_IN_FLIGHT);
-    _render_fin_semas.resize(MAX_FRAMES_IN_FLIGHT);
-    _rendering_fences.resize(MAX_FRAMES_IN_FLIGHT);
+void Application::fill_opaque_queue() {
+    _opaque_queue.clear();
+
+    for(uint32_t i = 0; i < _scene.draw_count; i++) {
+        OpaqueDraw draw{};
+        draw.index_count    = _quad_mesh.get_index_count();
+        draw.instance_count = _scene.instance_count;
+
+        // later draws are nearer, so the depth tested image matches the one drawn in scene order without depth
+        if(_depth_format != VK_FORMAT_UNDEFINED)
+            draw.depth = 1.0f - static_cast<float>(i + 1) / static_cast<float>(_scene.draw_count + 1);
+
+        _opaque_queue.push(draw);
+    }
+
+    _opaque_queue.sort_front_to_back();
+}
+
+void Application::emit_scene_sprites() {
+    if(_sprites_available == false || _scene.sprite_count == 0)
+        return;
+
+    const Pipeline &pipeline = _bindless_available ? _bindless_sprite_pipeline : _sprite_pipeline;
+
+    SpriteMaterial material{};
+    material.pipeline = pipeline.get_raw_graphics_handle();
+    material.layout   = pipeline.get_raw_layout_handle();
+
+    // a square grid covering the screen, each sprite spinning at its own phase
+    uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(_scene.sprite_count))));
+    float cell = 2.0f / static_cast<float>(columns);
+    float time = static_cast<float>(_frame_number) * 0.02f;
+
+    for(uint32_t i = 0; i < _scene.sprite_count; i++) {
+        uint32_t column = i % columns;
+        uint32_t row    = i / columns;
+
+        SpriteInstance sprite{};
+        sprite.center    = { -1.0f + cell * (column + 0.5f), -1.0f + cell * (row + 0.5f) };
+        sprite.half_size = { cell * 0.35f, cell * 0.35f };
+        sprite.color     = 0xff000000 | (column * 37 % 256) | (row * 59 % 256) << 8 | (i * 13 % 256) << 16;
+        sprite.rotation  = time + static_cast<float>(i) * 0.1f;
+
+        // textured and untextured sprites alternate, yet all of them still end up in a single batch
+        sprite.texture_idx = (i % 2 == 0) ? _sprite_texture_idx : INVALID_BINDLESS_IDX;
+
+        if(_sprite_batcher.draw(material, sprite) == false)
+            break;
+    }
+}
+
+void Application::push_frame_uniforms() {
+    FrameUniforms uniforms{};
+    uniforms.time = static_cast<float>(_frame_number) * 0.02f;
+
+    if(_uniform_ring.push(uniforms, &_frame_uniform_offset) == false)
+        _frame_uniform_offset = 0;
+}
+
+void Application::bind_frame_uniforms(VkCommandBuffer cmd_buf) const {
+    if(_sprites_available == false || _sprite_batcher.has_pending() == false ||
+       _uniform_ring.get_raw_set_layout_handle() == VK_NULL_HANDLE)
+        return;
+
+    const Pipeline &pipeline = _bindless_available ? _bindless_sprite_pipeline : _sprite_pipeline;
+
+    // every layout from the cache shares the ring's set, so this stays bound across the batcher's pipeline switches
+    _uniform_ring.bind(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get_raw_layout_handle(),
+                       _frame_uniform_offset);
+}
+
+bool Application::record_sprites_secondary(const VkCommandBufferInheritanceInfo &inheritance) {
+    if(_sprite_batcher.has_pending() == false)
+        return true;
+
+    VkCommandBuffer secondary = VK_NULL_HANDLE;
+
+    if(_frame_context.get_cmd_buf(VK_COMMAND_BUFFER_LEVEL_SECONDARY, &secondary) == false)
+        return false;
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance;
+
+    if(vkBeginCommandBuffer(secondary, &begin_info) != VK_SUCCESS)
+        return false;
 
+    vkCmdSetViewport(secondary, 0, 1, &_viewport);
+    vkCmdSetScissor(secondary, 0, 1, &_scissor);
+
+    bind_frame_uniforms(secondary);
+    _sprite_batcher.flush(secondary);
+
+    if(vkEndCommandBuffer(secondary) != VK_SUCCESS)
+        return false;
+
+    _secondary_cmd_bufs.push_back(secondary);
+
+    return true;
+}
+
+bool Application::setup_synchronize_objs() {
     VkSemaphoreCreateInfo sem_info{};
     sem_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
@@ -409,32 +1176,125 @@ bool Application::setup_synchronize_objs() {
 
     VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
 
-    for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if(vkCreateSemaphore(logical, &sem_info, nullptr, &_img_avail_semas[i]) != VK_SUCCESS)
-            return false;
+    // the presentation engine only understands binary semaphores, headless there is nothing to present
+    if(_headless == false) {
+        _img_avail_semas.resize(_frames_in_flight);
+        _render_fin_semas.resize(_frames_in_flight);
 
-        if(vkCreateSemaphore(logical, &sem_info, nullptr, &_render_fin_semas[i]) != VK_SUCCESS)
-            return false;
+        for(uint32_t i = 0; i < _frames_in_flight; i++) {
+            if(vkCreateSemaphore(logical, &sem_info, nullptr, &_img_avail_semas[i]) != VK_SUCCESS)
+                return false;
+
+            if(vkCreateSemaphore(logical, &sem_info, nullptr, &_render_fin_semas[i]) != VK_SUCCESS)
+                return false;
+        }
+    }
+
+    // a single timeline semaphore replaces the fences, each frame slot remembers the value it signals
+    if(_use_timeline) {
+        _frame_timeline_values.assign(_frames_in_flight, 0);
+
+        return _graphics_timeline.init(logical);
+    }
 
+    _rendering_fences.resize(_frames_in_flight);
+
+    for(uint32_t i = 0; i < _frames_in_flight; i++) {
         if(vkCreateFence(logical, &fence_info, nullptr, &_rendering_fences[i]) != VK_SUCCESS)
             return false;
     }
 
-
     return true;
 }
 
+void Application::begin_frame_wait() {
+    // pacing first, so the frame that follows still starts from the freshest gpu state
+    _frame_limiter.wait();
+    wait_for_previous_frame();
+}
+
+void Application::wait_for_previous_frame() {
+    _latency_wait_ms = 0.0;
+
+    if(_low_latency == false)
+        return;
+
+    auto wait_start = std::chrono::steady_clock::now();
+
+    // the most recent submit finishes last, so waiting on it covers every frame in flight
+    if(_use_timeline)
+        _graphics_timeline.wait(_graphics_timeline.get_last_value());
+    else {
+        size_t prev_frame = (_current_frame + _frames_in_flight - 1) % _frames_in_flight;
+        VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
+
+        vkWaitForFences(logical, 1, &_rendering_fences[prev_frame], VK_TRUE, UINT64_MAX);
+    }
+
+    _latency_wait_ms = elapsed_ms(wait_start);
+}
+
 bool Application::draw_frame() {
     VkDevice logical = _vk_core.get_device_manager_ptr()->get_logical();
     VkSwapchainKHR &raw_swpchn = _vk_core.get_swap_chain_ptr()->get_raw_handle_ref();
 
+    auto frame_start = std::chrono::steady_clock::now();
+    _frame_stats = {};
+    _frame_stats.latency_wait_ms  = _latency_wait_ms;
+    _frame_stats.pacing_wait_ms   = _frame_limiter.get_last_wait_ms();
+    _frame_stats.pacing_jitter_ms = _frame_limiter.get_last_jitter_ms();
+
     // wait for previous frame
-    vkWaitForFences(logical, 1, &_rendering_fences[_current_frame], VK_TRUE, UINT64_MAX);
+    if(_use_timeline)
+        _graphics_timeline.wait(_frame_timeline_values[_current_frame]);
+    else
+        vkWaitForFences(logical, 1, &_rendering_fences[_current_frame], VK_TRUE, UINT64_MAX);
+
+    _frame_stats.fence_wait_ms = elapsed_ms(frame_start);
+
+    // the fence signaled, so the queries this frame slot recorded last time are ready
+    _frame_stats.gpu_valid = _gpu_profiler.read_frame(_current_frame, &_frame_stats.gpu_ms, &_gpu_pass_stats);
+
+    // objects retired before every slot finished once more, like old swap chains, are no longer in use
+    _deletion_queue.begin_frame(static_cast<uint32_t>(_current_frame));
+
+    // the fence signaled, so every command buffer this frame slot recorded last time is free again
+    if(_frame_context.begin_frame(_current_frame) == false) {
+        spdlog::error("failed to reset the frame command pool!");
+        return false;
+    }
+
+    if(_parallel_recording)
+        _parallel_recorder.begin_frame(_current_frame);
+
+    // the graphics fence already covers the compute submission it waited on, so this never blocks for long
+    if(_async_compute && _compute_queue.begin_frame(_current_frame) == false) {
+        spdlog::error("failed to reset the compute command pool!");
+        return false;
+    }
+
+    // this frame's region of the instance buffer is no longer read by the gpu
+    _sprite_batcher.begin_frame(_current_frame);
+    _uniform_ring.begin_frame(_current_frame);
+
+    _frame_number++;
+    push_frame_uniforms();
+    emit_scene_sprites();
     
     // draw on the commands
     uint32_t img_idx;
-    VkResult acquire_result = vkAcquireNextImageKHR(logical, raw_swpchn, UINT64_MAX,
-                                            _img_avail_semas[_current_frame], VK_NULL_HANDLE, &img_idx);
+    VkResult acquire_result = VK_SUCCESS;
+
+    auto acquire_start = std::chrono::steady_clock::now();
+
+    // each frame in flight owns its own offscreen image, which is free once its fence signaled
+    if(_headless)
+        img_idx = static_cast<uint32_t>(_current_frame);
+    else
+        acquire_result = vkAcquireNextImageKHR(logical, raw_swpchn, UINT64_MAX,
+                                               _img_avail_semas[_current_frame], VK_NULL_HANDLE, &img_idx);
+
+    _frame_stats.acquire_ms = elapsed_ms(acquire_start);
     
     if(acquire_result == VK_ERROR_OUT_OF_DATE_KHR) {
         spdlog::info("image out of date, recreating swap chain");
@@ -451,33 +1311,141 @@ bool Application::draw_frame() {
         return false;
     }
 
-    vkResetFences(logical, 1, &_rendering_fences[_current_frame]);
-    
+    // everything signaled for this frame so far, every bail out from here on has to drain it
+    VkSemaphore          wait_semas[3];
+    VkPipelineStageFlags wait_stages[3];
+    uint64_t             wait_values[3] = {}; // only read for timeline semaphores
+    uint32_t wait_count = 0;
 
+    VkSemaphore signal_semas[2];
+    uint64_t    signal_values[2] = {};
+    uint32_t signal_count = 0;
+
+    // there is no presentation engine to synchronize with when headless, the fence or timeline alone is enough
+    if(_headless == false) {
+        wait_semas[wait_count]  = _img_avail_semas[_current_frame];
+        wait_stages[wait_count] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // wait until color has output
+        wait_count++;
+
+        signal_semas[signal_count++] = _render_fin_semas[_current_frame];
+    }
 
-    vkResetCommandBuffer(_cmd_buffers[_current_frame], 0);
-    record_command_buffer(_cmd_buffers[_current_frame], img_idx);
+    VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+
+    if(_frame_context.get_cmd_buf(VK_COMMAND_BUFFER_LEVEL_PRIMARY, &cmd_buf) == false) {
+        spdlog::error("failed to get a frame command buffer!");
+        drain_waits(wait_semas, wait_stages, wait_values, wait_count);
+        return false;
+    }
+
+    if(record_command_buffer(cmd_buf, img_idx) == false) {
+        spdlog::error("failed to record the frame command buffer!");
+        drain_waits(wait_semas, wait_stages, wait_values, wait_count);
+        return false;
+    }
 
     VkSubmitInfo submit_info{};
     submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &_cmd_buffers[_current_frame];
+    submit_info.pCommandBuffers = &cmd_buf;
+
+    // uploads staged since the last frame run on the transfer queue, only the stages reading them wait
+    VkSemaphore upload_sema = _upload_service.flush();
+
+    // the cull overlaps with whatever the graphics queue is still busy with
+    if(_async_compute && _gpu_culling) {
+        VkPipelineStageFlags compute_stages = 0;
+        uint64_t compute_value = 0;
+        VkSemaphore compute_sema = submit_async_cull(upload_sema, &compute_stages, &compute_value);
+
+        if(compute_sema == VK_NULL_HANDLE) {
+            spdlog::error("failed to submit the async compute work!");
+
+            // the upload batch already signaled its semaphore, left unwaited the next flush would signal it again
+            if(upload_sema != VK_NULL_HANDLE) {
+                wait_semas[wait_count]  = upload_sema;
+                wait_stages[wait_count] = UPLOAD_WAIT_STAGES;
+                wait_count++;
+            }
+
+            drain_waits(wait_semas, wait_stages, wait_values, wait_count);
+            return false;
+        }
 
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = &_img_avail_semas[_current_frame];
+        wait_semas[wait_count]  = compute_sema;
+        wait_stages[wait_count] = compute_stages;
+        wait_values[wait_count] = compute_value;
+        wait_count++;
 
-    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // wait until color has output
-    submit_info.pWaitDstStageMask = &wait_stage;
+        upload_sema = VK_NULL_HANDLE; // forwarded through the compute submit
+    }
+
+    if(upload_sema != VK_NULL_HANDLE) {
+        wait_semas[wait_count]  = upload_sema;
+        wait_stages[wait_count] = UPLOAD_WAIT_STAGES;
+        wait_count++;
+    }
+
+    submit_info.waitSemaphoreCount = wait_count;
+    submit_info.pWaitSemaphores = wait_semas;
+    submit_info.pWaitDstStageMask = wait_stages;
+
+    VkFence submit_fence = VK_NULL_HANDLE;
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+
+    // only committed once the submit succeeded, nothing would ever signal it otherwise
+    uint64_t frame_value = _graphics_timeline.get_pending_value();
+
+    if(_use_timeline) {
+        signal_semas[signal_count]  = _graphics_timeline.get_raw_handle();
+        signal_values[signal_count] = frame_value;
+        signal_count++;
 
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = &_render_fin_semas[_current_frame];
+        timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_info.waitSemaphoreValueCount = wait_count;
+        timeline_info.pWaitSemaphoreValues = wait_values;
+        timeline_info.signalSemaphoreValueCount = signal_count;
+        timeline_info.pSignalSemaphoreValues = signal_values;
+
+        submit_info.pNext = &timeline_info;
+    }
+    else
+        submit_fence = _rendering_fences[_current_frame];
+
+    submit_info.signalSemaphoreCount = signal_count;
+    submit_info.pSignalSemaphores = signal_semas;
 
     VkQueue &graphics_queue = _vk_core.get_graphics_queue_ref();
+
+    // reset only right before the submit, the bail outs before it leave the fence signaled since the next wait on
+    // this slot would never return otherwise. They drain the semaphores the frame signaled for the same reason
+    if(submit_fence != VK_NULL_HANDLE)
+        vkResetFences(logical, 1, &submit_fence);
     
-    if(vkQueueSubmit(graphics_queue, 1, &submit_info, _rendering_fences[_current_frame]) != VK_SUCCESS)
+    if(vkQueueSubmit(graphics_queue, 1, &submit_info, submit_fence) != VK_SUCCESS) {
+        spdlog::error("failed to submit the frame!");
+
+        drain_waits(wait_semas, wait_stages, wait_values, wait_count);
+
+        // an empty batch signals the fence the failed submit was meant to
+        if(submit_fence != VK_NULL_HANDLE)
+            vkQueueSubmit(graphics_queue, 0, nullptr, submit_fence);
+
         return false;
+    }
     // else
 
+    if(_use_timeline) {
+        _graphics_timeline.commit_value();
+        _frame_timeline_values[_current_frame] = frame_value;
+    }
+
+    if(_headless) {
+        _current_frame = (_current_frame + 1) % _frames_in_flight;
+        _frame_stats.cpu_frame_ms = elapsed_ms(frame_start);
+        return true;
+    }
+
     // submitted, now we need to present, but wait render finished
     VkPresentInfoKHR present_info{};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -493,40 +1461,78 @@ bool Application::draw_frame() {
 
     VkResult present_result = vkQueuePresentKHR(present_queue, &present_info);
 
+    bool success = true;
+
+    // the frame was submitted either way, so the slot still advances
     if(present_result == VK_ERROR_OUT_OF_DATE_KHR || present_result == VK_SUBOPTIMAL_KHR) {
         spdlog::info("image out of date, recreating swap chain");
 
         Swapchain *swapchain_ptr = _vk_core.get_swap_chain_ptr();
 
-        bool success = recreate_swap_chain_and_views();
+        success = recreate_swap_chain_and_views();
         set_viewport_extents_scissors(swapchain_ptr->get_img_extent());
-        return success;
     }
-
-    if(present_result != VK_SUCCESS) {
-        spdlog::error("failed to acquire swap chain image!");
+    else if(present_result != VK_SUCCESS) {
+        spdlog::error("failed to present swap chain image!");
         return false;
     }
 
-    _current_frame = (_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+    _current_frame = (_current_frame + 1) % _frames_in_flight;
+    _frame_stats.cpu_frame_ms = elapsed_ms(frame_start);
 
-    return true;
+    return success;
+}
+
+void Application::drain_waits(const VkSemaphore *semas, const VkPipelineStageFlags *stages,
+                              const uint64_t *values, uint32_t count) {
+    if(count == 0)
+        return;
+
+    // the compute semaphore is the timeline when frames are tracked with one
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.waitSemaphoreValueCount = count;
+    timeline_info.pWaitSemaphoreValues = values;
+
+    VkSubmitInfo drain_info{};
+    drain_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    drain_info.pNext = _use_timeline ? &timeline_info : nullptr;
+    drain_info.waitSemaphoreCount = count;
+    drain_info.pWaitSemaphores = semas;
+    drain_info.pWaitDstStageMask = stages;
+
+    if(vkQueueSubmit(_vk_core.get_graphics_queue_ref(), 1, &drain_info, VK_NULL_HANDLE) != VK_SUCCESS)
+        spdlog::error("failed to drain the semaphores of a dropped frame!");
 }
 
 bool Application::recreate_swap_chain_and_views() {
     VkDeviceManager *device_manager_ptr = _vk_core.get_device_manager_ptr();
     VkDevice logical = device_manager_ptr->get_logical();
 
-    vkDeviceWaitIdle(logical);
+    // no device wait, frames still in flight keep rendering into and presenting the old images
+    VkSwapchainKHR old_swap_chain = VK_NULL_HANDLE;
 
-    if(_vk_core.recreate_swap_chain(_win_ptr))
+    if(_vk_core.recreate_swap_chain(_win_ptr, &old_swap_chain))
         spdlog::info("recreate swap chain success");
     else {
         spdlog::error("recreate swap chain failed");
         return false;
     }
 
-    destroy_views_and_frame_buffers();
+    std::vector<VkImageView>   old_views = std::move(_swpchn_views);
+    std::vector<VkFramebuffer> old_frame_buffers = std::move(_swpchn_frame_buffers);
+    _swpchn_views.clear();
+    _swpchn_frame_buffers.clear();
+
+    _deletion_queue.retire([logical, old_views, old_frame_buffers, old_swap_chain]() {
+        for(VkFramebuffer frame_buffer : old_frame_buffers)
+            vkDestroyFramebuffer(logical, frame_buffer, nullptr);
+
+        for(VkImageView img_view : old_views)
+            vkDestroyImageView(logical, img_view, nullptr);
+
+        vkDestroySwapchainKHR(logical, old_swap_chain, nullptr);
+    });
 
     _vk_core.get_swap_chain_ptr()->get_images(&_swpchn_imgs);
 
@@ -535,25 +1541,27 @@ bool Application::recreate_swap_chain_and_views() {
         return false;
     }
 
-    if(!setup_swap_chain_frame_buffers()) {
-        spdlog::error("recreate swap chain frame buffers failed!");
+    // transients are sized after the swap chain, the frame buffers are created along with them
+    if(build_render_graph() == false) {
+        spdlog::error("rebuilding the render graph and frame buffers failed!");
         return false;
     }
 
-    return false;
+    return true;
 }
 
 void Application::destroy_views_and_frame_buffers() {
     VkDeviceManager *device_manager_ptr = _vk_core.get_device_manager_ptr();
     VkDevice logical = device_manager_ptr->get_logical();
     
-    for(size_t i = 0; i < _swpchn_imgs.size(); i++) {
-        VkImageView img_view = _swpchn_views[i];
+    for(VkFramebuffer frame_buffer : _swpchn_frame_buffers)
+        vkDestroyFramebuffer(logical, frame_buffer, nullptr);
+
+    for(VkImageView img_view : _swpchn_views)
         vkDestroyImageView(logical, img_view, nullptr);
 
-        VkFramebuffer frame_buffer = _swpchn_frame_buffers[i];
-        vkDestroyFramebuffer(logical, frame_buffer, nullptr);
-    }
+    _swpchn_frame_buffers.clear();
+    _swpchn_views.clear();
 }
 
 
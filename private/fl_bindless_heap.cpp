@@ -0,0 +1,261 @@
+#include <fl_bindless_heap.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace fl {
+
+uint32_t BindlessHeap::SlotAllocator::acquire() {
+    if(freed.empty() == false) {
+        uint32_t idx = freed.back();
+        freed.pop_back();
+
+        return idx;
+    }
+
+    return next < capacity ? next++ : INVALID_BINDLESS_IDX;
+}
+
+void BindlessHeap::SlotAllocator::release(uint32_t idx) {
+    if(idx < next)
+        freed.push_back(idx);
+}
+
+uint32_t BindlessHeap::SlotAllocator::get_used() const {
+    return next - static_cast<uint32_t>(freed.size());
+}
+
+BindlessHeap::BindlessHeap() {
+}
+
+BindlessHeap::~BindlessHeap() {
+    destroy();
+}
+
+bool BindlessHeap::init(VkPhysicalDevice physical, VkDevice logical,
+                        uint32_t texture_capacity, uint32_t buffer_capacity) {
+    _logical_device = logical;
+
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_props{};
+    indexing_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 props{};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props.pNext = &indexing_props;
+
+    vkGetPhysicalDeviceProperties2(physical, &props);
+
+    // combined image samplers count against both the sampler and the sampled image limits
+    texture_capacity = std::min({ texture_capacity,
+                                  indexing_props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                  indexing_props.maxPerStageDescriptorUpdateAfterBindSamplers,
+                                  indexing_props.maxDescriptorSetUpdateAfterBindSampledImages,
+                                  indexing_props.maxDescriptorSetUpdateAfterBindSamplers });
+
+    buffer_capacity = std::min({ buffer_capacity,
+                                 indexing_props.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                                 indexing_props.maxDescriptorSetUpdateAfterBindStorageBuffers });
+
+    _texture_slots = SlotAllocator{ texture_capacity };
+    _buffer_slots  = SlotAllocator{ buffer_capacity };
+
+    VkDescriptorSetLayoutBinding bindings[2]{};
+
+    bindings[0].binding         = BINDLESS_TEXTURE_BINDING;
+    bindings[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = texture_capacity;
+    bindings[0].stageFlags      = VK_SHADER_STAGE_ALL;
+
+    bindings[1].binding         = BINDLESS_BUFFER_BINDING;
+    bindings[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = buffer_capacity;
+    bindings[1].stageFlags      = VK_SHADER_STAGE_ALL;
+
+    // slots nobody wrote yet are never accessed, and writes may land while earlier frames still use the set
+    VkDescriptorBindingFlags binding_flags[2] = {};
+
+    for(VkDescriptorBindingFlags &flags : binding_flags)
+        flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info{};
+    flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flags_info.bindingCount = 2;
+    flags_info.pBindingFlags = binding_flags;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.pNext = &flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layout_info.bindingCount = 2;
+    layout_info.pBindings = bindings;
+
+    if(vkCreateDescriptorSetLayout(_logical_device, &layout_info, nullptr, &_set_layout) != VK_SUCCESS) {
+        spdlog::error("[BindlessHeap] failed to create descriptor set layout");
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_sizes[2]{};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[0].descriptorCount = texture_capacity;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_sizes[1].descriptorCount = buffer_capacity;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+
+    if(vkCreateDescriptorPool(_logical_device, &pool_info, nullptr, &_pool) != VK_SUCCESS) {
+        spdlog::error("[BindlessHeap] failed to create descriptor pool");
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = _pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &_set_layout;
+
+    if(vkAllocateDescriptorSets(_logical_device, &alloc_info, &_set) != VK_SUCCESS) {
+        spdlog::error("[BindlessHeap] failed to allocate the descriptor set");
+        return false;
+    }
+
+    VkSamplerCreateInfo sampler_info{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+
+    if(vkCreateSampler(_logical_device, &sampler_info, nullptr, &_default_sampler) != VK_SUCCESS) {
+        spdlog::error("[BindlessHeap] failed to create the default sampler");
+        return false;
+    }
+
+    spdlog::info("[BindlessHeap] {} texture and {} buffer slots", texture_capacity, buffer_capacity);
+
+    return true;
+}
+
+void BindlessHeap::destroy() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // the set goes away with its pool
+    vkDestroySampler(_logical_device, _default_sampler, nullptr);
+    vkDestroyDescriptorPool(_logical_device, _pool, nullptr);
+    vkDestroyDescriptorSetLayout(_logical_device, _set_layout, nullptr);
+
+    _default_sampler = VK_NULL_HANDLE;
+    _pool = VK_NULL_HANDLE;
+    _set  = VK_NULL_HANDLE;
+    _set_layout = VK_NULL_HANDLE;
+
+    _texture_slots = SlotAllocator{};
+    _buffer_slots  = SlotAllocator{};
+}
+
+uint32_t BindlessHeap::add_texture(VkImageView view, VkSampler sampler) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t idx = _texture_slots.acquire();
+
+    if(idx == INVALID_BINDLESS_IDX) {
+        spdlog::error("[BindlessHeap] every one of the {} texture slots is taken", _texture_slots.capacity);
+        return INVALID_BINDLESS_IDX;
+    }
+
+    VkDescriptorImageInfo img_info{};
+    img_info.sampler = sampler != VK_NULL_HANDLE ? sampler : _default_sampler;
+    img_info.imageView = view;
+    img_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _set;
+    write.dstBinding = BINDLESS_TEXTURE_BINDING;
+    write.dstArrayElement = idx;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &img_info;
+
+    vkUpdateDescriptorSets(_logical_device, 1, &write, 0, nullptr);
+
+    return idx;
+}
+
+uint32_t BindlessHeap::add_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t idx = _buffer_slots.acquire();
+
+    if(idx == INVALID_BINDLESS_IDX) {
+        spdlog::error("[BindlessHeap] every one of the {} buffer slots is taken", _buffer_slots.capacity);
+        return INVALID_BINDLESS_IDX;
+    }
+
+    VkDescriptorBufferInfo buf_info{};
+    buf_info.buffer = buffer;
+    buf_info.offset = offset;
+    buf_info.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = _set;
+    write.dstBinding = BINDLESS_BUFFER_BINDING;
+    write.dstArrayElement = idx;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &buf_info;
+
+    vkUpdateDescriptorSets(_logical_device, 1, &write, 0, nullptr);
+
+    return idx;
+}
+
+void BindlessHeap::remove_texture(uint32_t idx) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // partially bound, the stale descriptor stays in place until the slot is written again
+    _texture_slots.release(idx);
+}
+
+void BindlessHeap::remove_buffer(uint32_t idx) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _buffer_slots.release(idx);
+}
+
+void BindlessHeap::bind(VkCommandBuffer cmd_buf, VkPipelineBindPoint bind_point, VkPipelineLayout layout) const {
+    vkCmdBindDescriptorSets(cmd_buf, bind_point, layout, BINDLESS_SET, 1, &_set, 0, nullptr);
+}
+
+VkDescriptorSetLayout BindlessHeap::get_raw_set_layout_handle() const {
+    return _set_layout;
+}
+
+VkDescriptorSet BindlessHeap::get_raw_set_handle() const {
+    return _set;
+}
+
+uint32_t BindlessHeap::get_texture_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _texture_slots.get_used();
+}
+
+uint32_t BindlessHeap::get_buffer_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _buffer_slots.get_used();
+}
+
+} // namespace fl
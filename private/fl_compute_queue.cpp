@@ -0,0 +1,200 @@
+#include <fl_compute_queue.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+ComputeQueue::ComputeQueue() {
+}
+
+ComputeQueue::~ComputeQueue() {
+    destroy();
+}
+
+bool ComputeQueue::init(VkDevice logical, uint32_t family_idx, VkQueue queue, uint32_t frame_count,
+                        bool use_timeline) {
+    _logical_device = logical;
+    _family_idx = family_idx;
+    _queue = queue;
+    _use_timeline = use_timeline;
+
+    if(_frame_context.init(logical, family_idx, frame_count) == false)
+        return false;
+
+    _frames.resize(frame_count);
+
+    if(use_timeline) {
+        if(_timeline.init(logical) == false)
+            return false;
+
+        spdlog::info("[ComputeQueue] submitting to family {}, tracked by a timeline semaphore", family_idx);
+
+        return true;
+    }
+
+    VkSemaphoreCreateInfo sema_info{};
+    sema_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT; // frames that never submitted have nothing to wait for
+
+    for(Frame &frame : _frames) {
+        if(vkCreateFence(logical, &fence_info, nullptr, &frame.fence) != VK_SUCCESS ||
+           vkCreateSemaphore(logical, &sema_info, nullptr, &frame.finished) != VK_SUCCESS) {
+            spdlog::error("[ComputeQueue] failed to create the frame sync objects");
+            return false;
+        }
+    }
+
+    spdlog::info("[ComputeQueue] submitting to family {}", family_idx);
+
+    return true;
+}
+
+void ComputeQueue::destroy() {
+    if(_frames.empty())
+        return;
+
+    vkQueueWaitIdle(_queue);
+
+    _timeline.destroy();
+
+    for(Frame &frame : _frames) {
+        vkDestroyFence(_logical_device, frame.fence, nullptr);
+        vkDestroySemaphore(_logical_device, frame.finished, nullptr);
+    }
+
+    _frames.clear();
+    _recorded.clear();
+    _wait_semas.clear();
+    _wait_stages.clear();
+
+    _frame_context.destroy();
+}
+
+bool ComputeQueue::begin_frame(size_t frame_idx) {
+    Frame &frame = _frames[frame_idx];
+    _frame_idx = frame_idx;
+
+    if(_use_timeline)
+        _timeline.wait(frame.timeline_value);
+    else
+        vkWaitForFences(_logical_device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+
+    // anything recorded for a frame that was dropped before submitting goes away with the pool reset, its waits
+    // were never consumed and must not leak into this frame's submit
+    _recorded.clear();
+    _wait_semas.clear();
+    _wait_stages.clear();
+
+    return _frame_context.begin_frame(frame_idx);
+}
+
+bool ComputeQueue::begin_recording(VkCommandBuffer *cmd_buf_ptr) {
+    VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+
+    if(_frame_context.get_cmd_buf(VK_COMMAND_BUFFER_LEVEL_PRIMARY, &cmd_buf) == false)
+        return false;
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if(vkBeginCommandBuffer(cmd_buf, &begin_info) != VK_SUCCESS)
+        return false;
+
+    _recorded.push_back(cmd_buf);
+    *cmd_buf_ptr = cmd_buf;
+
+    return true;
+}
+
+void ComputeQueue::add_wait(VkSemaphore sema, VkPipelineStageFlags stages) {
+    _wait_semas.push_back(sema);
+    _wait_stages.push_back(stages);
+}
+
+VkSemaphore ComputeQueue::submit(uint64_t *value_ptr) {
+    // a batch without command buffers still forwards its waits to the semaphore it signals
+    if(_recorded.empty() && _wait_semas.empty())
+        return VK_NULL_HANDLE;
+
+    for(VkCommandBuffer cmd_buf : _recorded) {
+        if(vkEndCommandBuffer(cmd_buf) != VK_SUCCESS) {
+            spdlog::error("[ComputeQueue] failed to end a command buffer");
+            return VK_NULL_HANDLE;
+        }
+    }
+
+    Frame &frame = _frames[_frame_idx];
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = static_cast<uint32_t>(_wait_semas.size());
+    submit_info.pWaitSemaphores = _wait_semas.data();
+    submit_info.pWaitDstStageMask = _wait_stages.data();
+    submit_info.commandBufferCount = static_cast<uint32_t>(_recorded.size());
+    submit_info.pCommandBuffers = _recorded.data();
+    submit_info.signalSemaphoreCount = 1;
+
+    // the waits are binary semaphores, their values are ignored
+    std::vector<uint64_t> wait_values(_wait_semas.size(), 0);
+
+    VkTimelineSemaphoreSubmitInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+
+    VkSemaphore signal_sema = frame.finished;
+    VkFence     fence       = frame.fence;
+    uint64_t    value       = 0;
+
+    // committed only once the submit succeeded, begin_frame would otherwise wait on a value never signaled
+    if(_use_timeline) {
+        value = _timeline.get_pending_value();
+
+        timeline_info.waitSemaphoreValueCount = static_cast<uint32_t>(wait_values.size());
+        timeline_info.pWaitSemaphoreValues = wait_values.data();
+        timeline_info.signalSemaphoreValueCount = 1;
+        timeline_info.pSignalSemaphoreValues = &value;
+
+        submit_info.pNext = &timeline_info;
+        signal_sema = _timeline.get_raw_handle();
+        fence = VK_NULL_HANDLE;
+    }
+    else
+        vkResetFences(_logical_device, 1, &frame.fence);
+
+    submit_info.pSignalSemaphores = &signal_sema;
+
+    VkResult result = vkQueueSubmit(_queue, 1, &submit_info, fence);
+
+    _recorded.clear();
+    _wait_semas.clear();
+    _wait_stages.clear();
+
+    if(result != VK_SUCCESS) {
+        spdlog::error("[ComputeQueue] failed to submit");
+
+        // the fence was already reset, an empty batch signals it again so begin_frame does not wait forever
+        if(_use_timeline == false)
+            vkQueueSubmit(_queue, 0, nullptr, frame.fence);
+
+        return VK_NULL_HANDLE;
+    }
+
+    if(_use_timeline) {
+        _timeline.commit_value();
+        frame.timeline_value = value;
+    }
+
+    if(value_ptr != nullptr)
+        *value_ptr = value;
+
+    return signal_sema;
+}
+
+uint32_t ComputeQueue::get_family_idx() const {
+    return _family_idx;
+}
+
+} // namespace fl
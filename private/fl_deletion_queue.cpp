@@ -0,0 +1,56 @@
+#include <fl_deletion_queue.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace fl {
+
+DeletionQueue::DeletionQueue() {
+}
+
+DeletionQueue::~DeletionQueue() {
+    destroy();
+}
+
+bool DeletionQueue::init(uint32_t frame_count) {
+    if(frame_count == 0) {
+        spdlog::error("[DeletionQueue] needs at least one frame slot");
+        return false;
+    }
+
+    _slot_serials.assign(frame_count, 0);
+    _serial = 0;
+
+    return true;
+}
+
+void DeletionQueue::destroy() {
+    for(Retired &retired : _pending)
+        retired.destroy_func();
+
+    _pending.clear();
+}
+
+void DeletionQueue::begin_frame(uint32_t frame_idx) {
+    _slot_serials[frame_idx] = ++_serial;
+
+    // a slot that has not begun since the retire may still be running a submission from before it
+    uint64_t safe_serial = *std::min_element(_slot_serials.begin(), _slot_serials.end());
+
+    // retired in order, so the safe ones are at the front
+    while(_pending.empty() == false && _pending.front().serial < safe_serial) {
+        _pending.front().destroy_func();
+        _pending.pop_front();
+    }
+}
+
+void DeletionQueue::retire(std::function<void()> &&destroy_func) {
+    _pending.push_back({ _serial, std::move(destroy_func) });
+}
+
+size_t DeletionQueue::get_pending_count() const {
+    return _pending.size();
+}
+
+} // namespace fl
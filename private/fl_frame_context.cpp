@@ -0,0 +1,84 @@
+#include <fl_frame_context.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+FrameContext::FrameContext() {
+}
+
+FrameContext::~FrameContext() {
+    destroy();
+}
+
+bool FrameContext::init(VkDevice logical, uint32_t queue_family_idx, uint32_t frame_count) {
+    _logical_device = logical;
+    _frames.resize(frame_count);
+
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // buffers are short lived and only ever reset together with their pool
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = queue_family_idx;
+
+    for(Frame &frame : _frames) {
+        if(vkCreateCommandPool(logical, &pool_info, nullptr, &frame.pool) != VK_SUCCESS) {
+            spdlog::error("[FrameContext] failed to create a frame command pool");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FrameContext::destroy() {
+    // destroying a pool frees every command buffer allocated from it
+    for(Frame &frame : _frames)
+        vkDestroyCommandPool(_logical_device, frame.pool, nullptr);
+
+    _frames.clear();
+}
+
+bool FrameContext::begin_frame(size_t frame_idx) {
+    Frame &frame = _frames[frame_idx];
+    _frame_idx = frame_idx;
+
+    // no release flag, the pool keeps its memory so recording the next frame does not allocate again
+    if(vkResetCommandPool(_logical_device, frame.pool, 0) != VK_SUCCESS)
+        return false;
+
+    frame.primaries.used = 0;
+    frame.secondaries.used = 0;
+
+    return true;
+}
+
+bool FrameContext::get_cmd_buf(VkCommandBufferLevel level, VkCommandBuffer *cmd_buf_ptr) {
+    Frame &frame = _frames[_frame_idx];
+    CmdBufList &list = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? frame.primaries : frame.secondaries;
+
+    if(list.used == list.cmd_bufs.size()) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = frame.pool;
+        alloc_info.level = level;
+        alloc_info.commandBufferCount = 1;
+
+        VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+
+        if(vkAllocateCommandBuffers(_logical_device, &alloc_info, &cmd_buf) != VK_SUCCESS)
+            return false;
+
+        list.cmd_bufs.push_back(cmd_buf);
+    }
+
+    *cmd_buf_ptr = list.cmd_bufs[list.used++];
+
+    return true;
+}
+
+size_t FrameContext::get_frame_idx() const {
+    return _frame_idx;
+}
+
+} // namespace fl
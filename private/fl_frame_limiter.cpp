@@ -0,0 +1,92 @@
+#include <fl_frame_limiter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace fl {
+
+// older sleep samples are forgotten past this, so the estimate follows changes in system load
+static const uint64_t MAX_SLEEP_SAMPLES = 512;
+
+static double to_ms(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+FrameLimiter::FrameLimiter() {
+}
+
+void FrameLimiter::set_target_fps(double fps) {
+    _target_fps = fps > 0.0 ? fps : 0.0;
+    _has_deadline = false;
+
+    if(_target_fps > 0.0)
+        _period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / _target_fps));
+}
+
+double FrameLimiter::get_target_fps() const {
+    return _target_fps;
+}
+
+void FrameLimiter::wait() {
+    _last_wait_ms   = 0.0;
+    _last_jitter_ms = 0.0;
+
+    if(_target_fps == 0.0)
+        return;
+
+    Clock::time_point start = Clock::now();
+
+    // more than a whole frame late restarts the grid, catching up would draw a burst of unpaced frames
+    if(_has_deadline == false || start - _next_deadline > _period) {
+        _next_deadline = start;
+        _has_deadline = true;
+    }
+
+    if(_next_deadline > start) {
+        sleep_until(_next_deadline);
+
+        // the remainder is shorter than a sleep can be trusted with
+        while(Clock::now() < _next_deadline)
+            ;
+    }
+
+    Clock::time_point woke = Clock::now();
+
+    _last_wait_ms   = to_ms(woke - start);
+    _last_jitter_ms = std::abs(to_ms(woke - _next_deadline));
+
+    _next_deadline += _period;
+}
+
+double FrameLimiter::get_last_wait_ms() const {
+    return _last_wait_ms;
+}
+
+double FrameLimiter::get_last_jitter_ms() const {
+    return _last_jitter_ms;
+}
+
+void FrameLimiter::sleep_until(Clock::time_point deadline) {
+    while(to_ms(deadline - Clock::now()) > _sleep_estimate_ms) {
+        Clock::time_point sleep_start = Clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        double observed_ms = to_ms(Clock::now() - sleep_start);
+
+        // welford's running variance, the estimate keeps a standard deviation of headroom. Once the sample
+        // count is capped the accumulated squares decay at the same rate the mean does
+        if(_sleep_samples == MAX_SLEEP_SAMPLES)
+            _sleep_m2 *= static_cast<double>(MAX_SLEEP_SAMPLES - 1) / static_cast<double>(MAX_SLEEP_SAMPLES);
+
+        _sleep_samples = std::min(_sleep_samples + 1, MAX_SLEEP_SAMPLES);
+
+        double delta = observed_ms - _sleep_mean_ms;
+        _sleep_mean_ms += delta / static_cast<double>(_sleep_samples);
+        _sleep_m2 += delta * (observed_ms - _sleep_mean_ms);
+
+        double std_dev = std::sqrt(_sleep_m2 / static_cast<double>(_sleep_samples));
+        _sleep_estimate_ms = _sleep_mean_ms + std_dev;
+    }
+}
+
+} // namespace fl
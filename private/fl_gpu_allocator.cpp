@@ -0,0 +1,357 @@
+#include <fl_gpu_allocator.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace fl {
+
+static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// whether the last byte of one resource and the first byte of the next land on the same granularity page
+static bool is_on_same_page(VkDeviceSize last_byte, VkDeviceSize first_byte, VkDeviceSize page_size) {
+    return (last_byte & ~(page_size - 1)) == (first_byte & ~(page_size - 1));
+}
+
+GpuAllocator::GpuAllocator() {
+}
+
+GpuAllocator::~GpuAllocator() {
+    destroy();
+}
+
+bool GpuAllocator::init(VkPhysicalDevice physical, VkDevice logical, VkDeviceSize block_size) {
+    _logical_device = logical;
+    _block_size = block_size;
+
+    // queried once, memory properties never change for the lifetime of the device
+    vkGetPhysicalDeviceMemoryProperties(physical, &_mem_props);
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physical, &props);
+
+    _buffer_image_granularity = std::max<VkDeviceSize>(props.limits.bufferImageGranularity, 1);
+
+    spdlog::info("[GpuAllocator] {} memory types, bufferImageGranularity {}",
+                 _mem_props.memoryTypeCount, _buffer_image_granularity);
+
+    return true;
+}
+
+void GpuAllocator::destroy() {
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    for(auto &block : _blocks) {
+        if(block.memory == VK_NULL_HANDLE)
+            continue;
+
+        if(block.allocation_count > 0)
+            spdlog::error("[GpuAllocator] block of memory type {} destroyed with {} live allocations",
+                          block.mem_type, block.allocation_count);
+
+        // freeing mapped memory implicitly unmaps it
+        vkFreeMemory(_logical_device, block.memory, nullptr);
+    }
+
+    _blocks.clear();
+}
+
+bool GpuAllocator::find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags props, uint32_t *mem_type_ptr) const {
+    for(uint32_t i = 0; i < _mem_props.memoryTypeCount; i++) {
+        if(type_filter & (1 << i) && (_mem_props.memoryTypes[i].propertyFlags & props) == props) {
+            *mem_type_ptr = i;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool GpuAllocator::alloc_buffer(VkBuffer buffer, VkMemoryPropertyFlags props, GpuAllocation *alloc_ptr) {
+    VkMemoryRequirements reqs{};
+    vkGetBufferMemoryRequirements(_logical_device, buffer, &reqs);
+
+    if(allocate(reqs, props, ResourceKind::LINEAR, alloc_ptr) == false)
+        return false;
+
+    return vkBindBufferMemory(_logical_device, buffer, alloc_ptr->memory, alloc_ptr->offset) == VK_SUCCESS;
+}
+
+bool GpuAllocator::alloc_image(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags props,
+                               GpuAllocation *alloc_ptr) {
+    VkMemoryRequirements reqs{};
+    vkGetImageMemoryRequirements(_logical_device, image, &reqs);
+
+    ResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::OPTIMAL : ResourceKind::LINEAR;
+
+    if(allocate(reqs, props, kind, alloc_ptr) == false)
+        return false;
+
+    return vkBindImageMemory(_logical_device, image, alloc_ptr->memory, alloc_ptr->offset) == VK_SUCCESS;
+}
+
+bool GpuAllocator::alloc_image_memory(const VkMemoryRequirements &reqs, VkMemoryPropertyFlags props,
+                                      GpuAllocation *alloc_ptr) {
+    return allocate(reqs, props, ResourceKind::OPTIMAL, alloc_ptr);
+}
+
+bool GpuAllocator::allocate(const VkMemoryRequirements &reqs, VkMemoryPropertyFlags props, ResourceKind kind,
+                            GpuAllocation *alloc_ptr) {
+    uint32_t mem_type;
+
+    if(find_mem_type(reqs.memoryTypeBits, props, &mem_type) == false) {
+        spdlog::error("[GpuAllocator] no memory type with the requested properties");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    uint32_t block_idx = 0;
+    VkDeviceSize offset = 0;
+    bool found = false;
+
+    // oversized resources would waste most of a shared block, give them their own allocation
+    if(reqs.size > _block_size / 2) {
+        if(create_block(mem_type, reqs.size, true, &block_idx) == false)
+            return false;
+
+        found = try_alloc_from_block(&_blocks[block_idx], reqs.size, reqs.alignment, kind, &offset);
+    }
+
+    for(uint32_t i = 0; i < _blocks.size() && found == false; i++) {
+        Block &block = _blocks[i];
+
+        if(block.memory == VK_NULL_HANDLE || block.dedicated || block.mem_type != mem_type)
+            continue;
+
+        if(try_alloc_from_block(&block, reqs.size, reqs.alignment, kind, &offset)) {
+            block_idx = i;
+            found = true;
+        }
+    }
+
+    if(found == false) {
+        // small heaps, like the device local host visible window on some gpus, get smaller blocks
+        VkDeviceSize heap_size = _mem_props.memoryHeaps[_mem_props.memoryTypes[mem_type].heapIndex].size;
+        VkDeviceSize block_size = std::max(std::min(_block_size, heap_size / 8), reqs.size);
+
+        if(create_block(mem_type, block_size, false, &block_idx) == false)
+            return false;
+
+        found = try_alloc_from_block(&_blocks[block_idx], reqs.size, reqs.alignment, kind, &offset);
+    }
+
+    if(found == false)
+        return false;
+
+    Block &block = _blocks[block_idx];
+    block.used += reqs.size;
+    block.allocation_count++;
+
+    alloc_ptr->memory     = block.memory;
+    alloc_ptr->offset     = offset;
+    alloc_ptr->size       = reqs.size;
+    alloc_ptr->mem_type   = mem_type;
+    alloc_ptr->block_idx  = block_idx;
+    alloc_ptr->mapped_ptr = block.mapped_ptr ? static_cast<char*>(block.mapped_ptr) + offset : nullptr;
+
+    return true;
+}
+
+bool GpuAllocator::create_block(uint32_t mem_type, VkDeviceSize size, bool dedicated, uint32_t *block_idx_ptr) {
+    VkMemoryAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = mem_type;
+
+    Block block{};
+    block.size = size;
+    block.mem_type = mem_type;
+    block.dedicated = dedicated;
+    block.chunks.push_back({ 0, size, ResourceKind::FREE });
+
+    if(vkAllocateMemory(_logical_device, &alloc_info, nullptr, &block.memory) != VK_SUCCESS) {
+        spdlog::error("[GpuAllocator] failed to allocate a block of {} bytes from memory type {}", size, mem_type);
+        return false;
+    }
+
+    // host visible blocks stay mapped for their whole lifetime, mapping is not free on every driver
+    if(_mem_props.memoryTypes[mem_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if(vkMapMemory(_logical_device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped_ptr) != VK_SUCCESS) {
+            vkFreeMemory(_logical_device, block.memory, nullptr);
+            return false;
+        }
+    }
+
+    // reuse the slot of a released dedicated block, so block indices of live allocations never shift
+    for(uint32_t i = 0; i < _blocks.size(); i++) {
+        if(_blocks[i].memory == VK_NULL_HANDLE) {
+            _blocks[i] = std::move(block);
+            *block_idx_ptr = i;
+            return true;
+        }
+    }
+
+    _blocks.push_back(std::move(block));
+    *block_idx_ptr = static_cast<uint32_t>(_blocks.size() - 1);
+
+    return true;
+}
+
+bool GpuAllocator::is_kind_conflict(ResourceKind a, ResourceKind b) const {
+    if(_buffer_image_granularity <= 1)
+        return false;
+
+    if(a == ResourceKind::FREE || b == ResourceKind::FREE)
+        return false;
+
+    return a != b;
+}
+
+bool GpuAllocator::try_alloc_from_block(Block *block_ptr, VkDeviceSize size, VkDeviceSize alignment,
+                                        ResourceKind kind, VkDeviceSize *offset_ptr) {
+    std::vector<Chunk> &chunks = block_ptr->chunks;
+
+    // first fit over the free chunks
+    for(size_t i = 0; i < chunks.size(); i++) {
+        const Chunk chunk = chunks[i];
+
+        if(chunk.kind != ResourceKind::FREE || chunk.size < size)
+            continue;
+
+        VkDeviceSize offset = align_up(chunk.offset, alignment);
+
+        if(i > 0) {
+            const Chunk &prev = chunks[i - 1];
+
+            if(is_kind_conflict(prev.kind, kind) &&
+               is_on_same_page(prev.offset + prev.size - 1, offset, _buffer_image_granularity))
+                offset = align_up(offset, _buffer_image_granularity);
+        }
+
+        VkDeviceSize end = offset + size;
+
+        if(end > chunk.offset + chunk.size)
+            continue;
+
+        if(i + 1 < chunks.size()) {
+            const Chunk &next = chunks[i + 1];
+
+            if(is_kind_conflict(kind, next.kind) &&
+               is_on_same_page(end - 1, next.offset, _buffer_image_granularity))
+                continue;
+        }
+
+        // split the free chunk into the leading padding, the allocation and whatever remains
+        std::vector<Chunk> split{};
+
+        if(offset > chunk.offset)
+            split.push_back({ chunk.offset, offset - chunk.offset, ResourceKind::FREE });
+
+        split.push_back({ offset, size, kind });
+
+        if(chunk.offset + chunk.size > end)
+            split.push_back({ end, chunk.offset + chunk.size - end, ResourceKind::FREE });
+
+        chunks.erase(chunks.begin() + i);
+        chunks.insert(chunks.begin() + i, split.begin(), split.end());
+
+        *offset_ptr = offset;
+        return true;
+    }
+
+    return false;
+}
+
+void GpuAllocator::free(GpuAllocation *alloc_ptr) {
+    if(alloc_ptr->memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    Block &block = _blocks[alloc_ptr->block_idx];
+    std::vector<Chunk> &chunks = block.chunks;
+
+    auto chunk_it = std::find_if(chunks.begin(), chunks.end(), [alloc_ptr](const Chunk &chunk) {
+        return chunk.offset == alloc_ptr->offset && chunk.kind != ResourceKind::FREE;
+    });
+
+    if(chunk_it == chunks.end()) {
+        spdlog::error("[GpuAllocator] freeing an allocation that does not belong to its block");
+        return;
+    }
+
+    size_t i = static_cast<size_t>(chunk_it - chunks.begin());
+    chunks[i].kind = ResourceKind::FREE;
+
+    // merge with the free neighbours, so the chunk list never holds two free chunks in a row
+    if(i + 1 < chunks.size() && chunks[i + 1].kind == ResourceKind::FREE) {
+        chunks[i].size += chunks[i + 1].size;
+        chunks.erase(chunks.begin() + i + 1);
+    }
+
+    if(i > 0 && chunks[i - 1].kind == ResourceKind::FREE) {
+        chunks[i - 1].size += chunks[i].size;
+        chunks.erase(chunks.begin() + i);
+    }
+
+    block.used -= alloc_ptr->size;
+    block.allocation_count--;
+
+    if(block.dedicated && block.allocation_count == 0) {
+        vkFreeMemory(_logical_device, block.memory, nullptr);
+        block = Block{};
+    }
+
+    *alloc_ptr = GpuAllocation{};
+}
+
+const VkPhysicalDeviceMemoryProperties* GpuAllocator::get_mem_props_ptr() const {
+    return &_mem_props;
+}
+
+void GpuAllocator::get_stats(GpuAllocatorStats *stats_ptr) const {
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    *stats_ptr = GpuAllocatorStats{};
+
+    for(const auto &block : _blocks) {
+        if(block.memory == VK_NULL_HANDLE)
+            continue;
+
+        stats_ptr->block_count++;
+        stats_ptr->allocation_count += block.allocation_count;
+        stats_ptr->bytes_reserved   += block.size;
+        stats_ptr->bytes_used       += block.used;
+    }
+}
+
+void GpuAllocator::log_stats() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+
+    for(uint32_t type = 0; type < _mem_props.memoryTypeCount; type++) {
+        GpuAllocatorStats type_stats{};
+
+        for(const auto &block : _blocks) {
+            if(block.memory == VK_NULL_HANDLE || block.mem_type != type)
+                continue;
+
+            type_stats.block_count++;
+            type_stats.allocation_count += block.allocation_count;
+            type_stats.bytes_reserved   += block.size;
+            type_stats.bytes_used       += block.used;
+        }
+
+        if(type_stats.block_count == 0)
+            continue;
+
+        spdlog::info("[GpuAllocator] memory type {}: {} blocks, {} allocations, {} / {} bytes used",
+                     type, type_stats.block_count, type_stats.allocation_count,
+                     type_stats.bytes_used, type_stats.bytes_reserved);
+    }
+}
+
+} // namespace fl
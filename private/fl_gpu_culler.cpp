@@ -0,0 +1,322 @@
+#include <fl_gpu_culler.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace fl {
+
+// the shader's push constants, the plane count is fixed so the shader can unroll the loop
+struct CullParams {
+    float    planes[6][4];
+    uint32_t object_count;
+};
+
+void get_frustum_planes(const float *view_proj, CullView *view_ptr) {
+    // element at column c and row r of the column major matrix
+    auto at = [view_proj](int r, int c) { return view_proj[c * 4 + r]; };
+
+    for(int i = 0; i < 4; i++) {
+        view_ptr->planes[0][i] = at(3, i) + at(0, i); // left
+        view_ptr->planes[1][i] = at(3, i) - at(0, i); // right
+        view_ptr->planes[2][i] = at(3, i) + at(1, i); // bottom
+        view_ptr->planes[3][i] = at(3, i) - at(1, i); // top
+        view_ptr->planes[4][i] = at(2, i);            // near, depth starts at 0 in vulkan
+        view_ptr->planes[5][i] = at(3, i) - at(2, i); // far
+    }
+
+    // normalized, so the distance compares against the sphere radius directly
+    for(float *plane : view_ptr->planes) {
+        float len = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+        if(len == 0.0f)
+            continue;
+
+        for(int i = 0; i < 4; i++)
+            plane[i] /= len;
+    }
+}
+
+GpuCuller::GpuCuller() {
+}
+
+GpuCuller::~GpuCuller() {
+    destroy();
+}
+
+bool GpuCuller::init(VkDevice logical, GpuAllocator *allocator_ptr, UploadService *upload_service_ptr,
+                     ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr, VkPipelineCache cache,
+                     uint32_t frame_count, bool draw_indirect_count, bool multi_draw_indirect, uint32_t max_objects) {
+    _logical_device     = logical;
+    _allocator_ptr      = allocator_ptr;
+    _upload_service_ptr = upload_service_ptr;
+    _max_objects = max_objects;
+    _multi_draw  = multi_draw_indirect;
+
+    if(draw_indirect_count) {
+        _draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(logical, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+
+    // without a gpu side count every object keeps its slot, culled ones are drawn with zero instances
+    _compact = _draw_indexed_indirect_count != nullptr;
+
+    if(create_pipeline(shader_library_ptr, layout_cache_ptr, cache) == false)
+        return false;
+
+    if(upload_service_ptr->create_device_local_buffer(static_cast<VkDeviceSize>(max_objects) * sizeof(CullObject),
+                                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                      &_object_buf, &_object_alloc) == false) {
+        spdlog::error("[GpuCuller] failed to create the object buffer");
+        return false;
+    }
+
+    _frames.resize(frame_count);
+
+    for(FrameCull &frame : _frames) {
+        // storage for the compute pass to write, indirect for the draws to read
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+        if(upload_service_ptr->create_device_local_buffer(
+               static_cast<VkDeviceSize>(max_objects) * sizeof(VkDrawIndexedIndirectCommand), usage,
+               &frame.commands, &frame.commands_alloc) == false ||
+           upload_service_ptr->create_device_local_buffer(sizeof(uint32_t), usage,
+                                                          &frame.count, &frame.count_alloc) == false) {
+            spdlog::error("[GpuCuller] failed to create the draw command buffers");
+            return false;
+        }
+    }
+
+    if(create_descriptor_sets() == false)
+        return false;
+
+    spdlog::info("[GpuCuller] {} objects at most, drawn {}", max_objects,
+                 _compact ? "with a gpu written count" : (_multi_draw ? "as one multi draw" : "one indirect draw each"));
+
+    return true;
+}
+
+void GpuCuller::destroy() {
+    if(_logical_device == VK_NULL_HANDLE)
+        return;
+
+    for(FrameCull &frame : _frames) {
+        vkDestroyBuffer(_logical_device, frame.commands, nullptr);
+        vkDestroyBuffer(_logical_device, frame.count, nullptr);
+
+        _allocator_ptr->free(&frame.commands_alloc);
+        _allocator_ptr->free(&frame.count_alloc);
+    }
+
+    _frames.clear();
+
+    if(_object_buf != VK_NULL_HANDLE) {
+        vkDestroyBuffer(_logical_device, _object_buf, nullptr);
+        _allocator_ptr->free(&_object_alloc);
+    }
+
+    // the sets go away with their pool, the layout belongs to the layout cache
+    vkDestroyDescriptorPool(_logical_device, _pool, nullptr);
+    vkDestroyPipeline(_logical_device, _pipeline, nullptr);
+
+    _object_buf = VK_NULL_HANDLE;
+    _pool     = VK_NULL_HANDLE;
+    _pipeline = VK_NULL_HANDLE;
+    _layout   = VK_NULL_HANDLE;
+    _set_layout = VK_NULL_HANDLE;
+    _object_count = 0;
+
+    _logical_device = VK_NULL_HANDLE;
+}
+
+bool GpuCuller::create_pipeline(ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr,
+                                VkPipelineCache cache) {
+    VkShaderModule module = VK_NULL_HANDLE;
+    ShaderReflection reflection{};
+
+    if(shader_library_ptr->get_module("vendor/shaders/cull.comp.spv", &module, &reflection) == false)
+        return false;
+
+    PipelineLayoutInfo layout_info{};
+
+    if(layout_cache_ptr->get_pipeline_layout(reflection, &layout_info) == false)
+        return false;
+
+    if(layout_info.set_layouts.size() <= CULL_SET) {
+        spdlog::error("[GpuCuller] cull.comp declares no set {}", CULL_SET);
+        return false;
+    }
+
+    _layout = layout_info.layout;
+
+    // decides at pipeline creation whether survivors are compacted, the shader is compiled once for both paths
+    VkBool32 compact = _compact ? VK_TRUE : VK_FALSE;
+
+    VkSpecializationMapEntry spec_entry{};
+    spec_entry.constantID = 0;
+    spec_entry.offset = 0;
+    spec_entry.size = sizeof(VkBool32);
+
+    VkSpecializationInfo spec_info{};
+    spec_info.mapEntryCount = 1;
+    spec_info.pMapEntries = &spec_entry;
+    spec_info.dataSize = sizeof(VkBool32);
+    spec_info.pData = &compact;
+
+    VkComputePipelineCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    create_info.stage.module = module;
+    create_info.stage.pName = "main";
+    create_info.stage.pSpecializationInfo = &spec_info;
+    create_info.layout = _layout;
+
+    if(vkCreateComputePipelines(_logical_device, cache, 1, &create_info, nullptr, &_pipeline) != VK_SUCCESS) {
+        spdlog::error("[GpuCuller] failed to create the compute pipeline");
+        return false;
+    }
+
+    _set_layout = layout_info.set_layouts[CULL_SET];
+
+    return true;
+}
+
+bool GpuCuller::create_descriptor_sets() {
+    uint32_t frame_count = static_cast<uint32_t>(_frames.size());
+
+    VkDescriptorPoolSize pool_size{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = 3 * frame_count;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = frame_count;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+
+    if(vkCreateDescriptorPool(_logical_device, &pool_info, nullptr, &_pool) != VK_SUCCESS) {
+        spdlog::error("[GpuCuller] failed to create descriptor pool");
+        return false;
+    }
+
+    std::vector<VkDescriptorSetLayout> set_layouts(frame_count, _set_layout);
+    std::vector<VkDescriptorSet> sets(frame_count);
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = _pool;
+    alloc_info.descriptorSetCount = frame_count;
+    alloc_info.pSetLayouts = set_layouts.data();
+
+    if(vkAllocateDescriptorSets(_logical_device, &alloc_info, sets.data()) != VK_SUCCESS) {
+        spdlog::error("[GpuCuller] failed to allocate the descriptor sets");
+        return false;
+    }
+
+    for(uint32_t i = 0; i < frame_count; i++) {
+        FrameCull &frame = _frames[i];
+        frame.set = sets[i];
+
+        VkDescriptorBufferInfo buf_infos[3]{};
+        buf_infos[0] = { _object_buf, 0, VK_WHOLE_SIZE };
+        buf_infos[1] = { frame.commands, 0, VK_WHOLE_SIZE };
+        buf_infos[2] = { frame.count, 0, VK_WHOLE_SIZE };
+
+        const uint32_t bindings[3] = { CULL_OBJECT_BINDING, CULL_COMMAND_BINDING, CULL_COUNT_BINDING };
+
+        VkWriteDescriptorSet writes[3]{};
+
+        for(uint32_t j = 0; j < 3; j++) {
+            writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[j].dstSet = frame.set;
+            writes[j].dstBinding = bindings[j];
+            writes[j].descriptorCount = 1;
+            writes[j].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[j].pBufferInfo = &buf_infos[j];
+        }
+
+        vkUpdateDescriptorSets(_logical_device, 3, writes, 0, nullptr);
+    }
+
+    return true;
+}
+
+bool GpuCuller::set_objects(const CullObject *objects, uint32_t count) {
+    if(count > _max_objects) {
+        spdlog::error("[GpuCuller] {} objects exceed the capacity of {}", count, _max_objects);
+        return false;
+    }
+
+    if(count != 0 && _upload_service_ptr->upload(_object_buf, 0, objects, count * sizeof(CullObject)) == false)
+        return false;
+
+    _object_count = count;
+
+    return true;
+}
+
+void GpuCuller::cull(VkCommandBuffer cmd_buf, size_t frame_idx, const CullView &view) {
+    const FrameCull &frame = _frames[frame_idx];
+
+    // the count restarts from zero every frame, the barrier orders the clear before the atomics
+    vkCmdFillBuffer(cmd_buf, frame.count, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier clear_barrier{};
+    clear_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clear_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clear_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &clear_barrier, 0, nullptr, 0, nullptr);
+
+    if(_object_count != 0) {
+        CullParams params{};
+        memcpy(params.planes, view.planes, sizeof(params.planes));
+        params.object_count = _object_count;
+
+        vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, CULL_SET, 1, &frame.set, 0, nullptr);
+        vkCmdPushConstants(cmd_buf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams), &params);
+
+        vkCmdDispatch(cmd_buf, (_object_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    }
+
+    // the draws read both the commands and the count through the indirect stage
+    VkMemoryBarrier draw_barrier{};
+    draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    draw_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    draw_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
+                         1, &draw_barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::draw(VkCommandBuffer cmd_buf, size_t frame_idx) const {
+    if(_object_count == 0)
+        return;
+
+    const FrameCull &frame = _frames[frame_idx];
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+    if(_compact) {
+        _draw_indexed_indirect_count(cmd_buf, frame.commands, 0, frame.count, 0, _object_count, stride);
+        return;
+    }
+
+    if(_multi_draw) {
+        vkCmdDrawIndexedIndirect(cmd_buf, frame.commands, 0, _object_count, stride);
+        return;
+    }
+
+    // a draw count above 1 needs multiDrawIndirect, the cpu cost grows with the objects again
+    for(uint32_t i = 0; i < _object_count; i++)
+        vkCmdDrawIndexedIndirect(cmd_buf, frame.commands, static_cast<VkDeviceSize>(i) * stride, 1, stride);
+}
+
+uint32_t GpuCuller::get_object_count() const {
+    return _object_count;
+}
+
+} // namespace fl
@@ -0,0 +1,241 @@
+#include <fl_gpu_profiler.hpp>
+#include <fl_vulkan_utils.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+// every frame owns a begin and an end timestamp, followed by a begin and an end timestamp per pass
+#define FRAME_TIMESTAMP_COUNT (2 + 2 * MAX_PROFILED_PASSES)
+
+// the values are written in bit order, so keep this in sync with the layout read in read_frame
+#define PIPELINE_STATS_FLAGS                                           \
+    (VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT         | \
+     VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT       | \
+     VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT       | \
+     VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT             | \
+     VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT)
+#define PIPELINE_STATS_VALUE_COUNT 5
+
+GpuProfiler::GpuProfiler() {
+}
+
+GpuProfiler::~GpuProfiler() {
+    destroy();
+}
+
+bool GpuProfiler::init(VkPhysicalDevice physical, VkDevice logical, uint32_t queue_family_idx, uint32_t frame_count,
+                       bool enable_pipeline_stats) {
+    _logical_device = logical;
+
+    std::vector<VkQueueFamilyProperties> queue_family_props{};
+    get_physical_queue_family_props(physical, &queue_family_props);
+
+    uint32_t valid_bits = queue_family_props[queue_family_idx].timestampValidBits;
+
+    if(valid_bits == 0) {
+        spdlog::info("[GpuProfiler] queue family {} does not support timestamps", queue_family_idx);
+        return true;
+    }
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physical, &props);
+
+    _timestamp_period = props.limits.timestampPeriod;
+    _timestamp_mask   = valid_bits >= 64 ? UINT64_MAX : (1ull << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo timestamp_info{};
+    timestamp_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    timestamp_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    timestamp_info.queryCount = frame_count * FRAME_TIMESTAMP_COUNT;
+
+    if(vkCreateQueryPool(logical, &timestamp_info, nullptr, &_timestamp_pool) != VK_SUCCESS)
+        return false;
+
+    if(enable_pipeline_stats) {
+        VkPhysicalDeviceFeatures features{};
+        vkGetPhysicalDeviceFeatures(physical, &features);
+
+        // the logical device enables every supported feature, so support here means it is enabled
+        if(features.pipelineStatisticsQuery) {
+            VkQueryPoolCreateInfo stats_info{};
+            stats_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            stats_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            stats_info.queryCount = frame_count * MAX_PROFILED_PASSES;
+            stats_info.pipelineStatistics = PIPELINE_STATS_FLAGS;
+
+            if(vkCreateQueryPool(logical, &stats_info, nullptr, &_stats_pool) != VK_SUCCESS)
+                return false;
+        }
+        else
+            spdlog::info("[GpuProfiler] pipeline statistics queries are not supported, only timing passes");
+    }
+
+    _frame_slots.assign(frame_count, FrameSlot{});
+    _timestamp_results.resize(FRAME_TIMESTAMP_COUNT);
+    _stats_results.resize(MAX_PROFILED_PASSES * PIPELINE_STATS_VALUE_COUNT);
+
+    _supported = true;
+
+    return true;
+}
+
+void GpuProfiler::destroy() {
+    vkDestroyQueryPool(_logical_device, _timestamp_pool, nullptr);
+    vkDestroyQueryPool(_logical_device, _stats_pool, nullptr);
+
+    _timestamp_pool = VK_NULL_HANDLE;
+    _stats_pool = VK_NULL_HANDLE;
+    _supported = false;
+}
+
+bool GpuProfiler::is_supported() const {
+    return _supported;
+}
+
+bool GpuProfiler::has_pipeline_stats() const {
+    return _stats_pool != VK_NULL_HANDLE;
+}
+
+VkQueryPipelineStatisticFlags GpuProfiler::get_pipeline_stats_flags() const {
+    return has_pipeline_stats() ? PIPELINE_STATS_FLAGS : 0;
+}
+
+uint32_t GpuProfiler::first_timestamp_query(size_t frame_idx) const {
+    return static_cast<uint32_t>(frame_idx) * FRAME_TIMESTAMP_COUNT;
+}
+
+uint32_t GpuProfiler::first_stats_query(size_t frame_idx) const {
+    return static_cast<uint32_t>(frame_idx) * MAX_PROFILED_PASSES;
+}
+
+void GpuProfiler::begin_frame(VkCommandBuffer cmd_buf, size_t frame_idx) {
+    if(_supported == false)
+        return;
+
+    FrameSlot &slot = _frame_slots[frame_idx];
+    slot.pass_names.clear();
+    slot.in_pass = false;
+
+    uint32_t first_query = first_timestamp_query(frame_idx);
+
+    vkCmdResetQueryPool(cmd_buf, _timestamp_pool, first_query, FRAME_TIMESTAMP_COUNT);
+
+    if(has_pipeline_stats())
+        vkCmdResetQueryPool(cmd_buf, _stats_pool, first_stats_query(frame_idx), MAX_PROFILED_PASSES);
+
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _timestamp_pool, first_query);
+}
+
+void GpuProfiler::end_frame(VkCommandBuffer cmd_buf, size_t frame_idx) {
+    if(_supported == false)
+        return;
+
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _timestamp_pool,
+                        first_timestamp_query(frame_idx) + 1);
+
+    _frame_slots[frame_idx].written = true;
+}
+
+void GpuProfiler::begin_pass(VkCommandBuffer cmd_buf, size_t frame_idx, const char *name) {
+    if(_supported == false)
+        return;
+
+    FrameSlot &slot = _frame_slots[frame_idx];
+
+    if(slot.pass_names.size() >= MAX_PROFILED_PASSES) {
+        spdlog::error("[GpuProfiler] more than {} passes in a frame, \"{}\" is not profiled", MAX_PROFILED_PASSES, name);
+        return;
+    }
+
+    uint32_t pass_idx = static_cast<uint32_t>(slot.pass_names.size());
+    slot.pass_names.emplace_back(name);
+    slot.in_pass = true;
+
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _timestamp_pool,
+                        first_timestamp_query(frame_idx) + 2 + pass_idx * 2);
+
+    if(has_pipeline_stats())
+        vkCmdBeginQuery(cmd_buf, _stats_pool, first_stats_query(frame_idx) + pass_idx, 0);
+}
+
+void GpuProfiler::end_pass(VkCommandBuffer cmd_buf, size_t frame_idx) {
+    FrameSlot &slot = _frame_slots[frame_idx];
+
+    if(_supported == false || slot.in_pass == false)
+        return;
+
+    uint32_t pass_idx = static_cast<uint32_t>(slot.pass_names.size()) - 1;
+    slot.in_pass = false;
+
+    if(has_pipeline_stats())
+        vkCmdEndQuery(cmd_buf, _stats_pool, first_stats_query(frame_idx) + pass_idx);
+
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _timestamp_pool,
+                        first_timestamp_query(frame_idx) + 3 + pass_idx * 2);
+}
+
+bool GpuProfiler::read_frame(size_t frame_idx, double *gpu_ms_ptr, std::vector<GpuPassStats> *passes_ptr) {
+    if(_supported == false || _frame_slots[frame_idx].written == false)
+        return false;
+
+    FrameSlot &slot = _frame_slots[frame_idx];
+
+    // each recording is read once, a frame dropped before end_frame would otherwise report these results again
+    slot.written = false;
+
+    uint32_t pass_count = static_cast<uint32_t>(slot.pass_names.size());
+    uint32_t timestamp_count = 2 + pass_count * 2;
+
+    // no wait bit, the fence already guarantees the results, so this never stalls
+    VkResult result = vkGetQueryPoolResults(_logical_device, _timestamp_pool, first_timestamp_query(frame_idx),
+                                            timestamp_count, timestamp_count * sizeof(uint64_t),
+                                            _timestamp_results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if(result != VK_SUCCESS)
+        return false;
+
+    bool stats_read = false;
+
+    if(has_pipeline_stats() && pass_count > 0) {
+        VkDeviceSize stride = PIPELINE_STATS_VALUE_COUNT * sizeof(uint64_t);
+
+        stats_read = vkGetQueryPoolResults(_logical_device, _stats_pool, first_stats_query(frame_idx),
+                                           pass_count, pass_count * stride, _stats_results.data(),
+                                           stride, VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+    }
+
+    auto ticks_to_ms = [this](uint64_t begin, uint64_t end) {
+        uint64_t ticks = (end - begin) & _timestamp_mask;
+        return static_cast<double>(ticks) * _timestamp_period / 1e6;
+    };
+
+    *gpu_ms_ptr = ticks_to_ms(_timestamp_results[0], _timestamp_results[1]);
+
+    if(passes_ptr == nullptr)
+        return true;
+
+    passes_ptr->resize(pass_count);
+
+    for(uint32_t i = 0; i < pass_count; i++) {
+        GpuPassStats &pass = (*passes_ptr)[i];
+
+        pass.name = slot.pass_names[i];
+        pass.gpu_ms = ticks_to_ms(_timestamp_results[2 + i * 2], _timestamp_results[3 + i * 2]);
+        pass.has_pipeline_stats = stats_read;
+
+        if(stats_read == false)
+            continue;
+
+        const uint64_t *values = &_stats_results[i * PIPELINE_STATS_VALUE_COUNT];
+
+        pass.input_vertices       = values[0];
+        pass.input_primitives     = values[1];
+        pass.vertex_invocations   = values[2];
+        pass.clipping_primitives  = values[3];
+        pass.fragment_invocations = values[4];
+    }
+
+    return true;
+}
+
+} // namespace fl
@@ -0,0 +1,204 @@
+#include <fl_layout_cache.hpp>
+#include <fl_shader_utils.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace fl {
+
+size_t LayoutCache::LayoutKeyHasher::operator()(const LayoutKey &key) const {
+    const uint32_t *words = reinterpret_cast<const uint32_t*>(key.data());
+
+    return static_cast<size_t>(hash_shader_code(words, key.size() * sizeof(uint64_t)));
+}
+
+LayoutCache::LayoutCache() {
+}
+
+LayoutCache::~LayoutCache() {
+    destroy();
+}
+
+bool LayoutCache::init(VkDevice logical) {
+    _logical_device = logical;
+
+    return true;
+}
+
+void LayoutCache::destroy() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for(auto &[key, info] : _pipeline_layouts)
+        vkDestroyPipelineLayout(_logical_device, info.layout, nullptr);
+
+    for(auto &[key, layout] : _set_layouts)
+        vkDestroyDescriptorSetLayout(_logical_device, layout, nullptr);
+
+    _pipeline_layouts.clear();
+    _set_layouts.clear();
+}
+
+bool LayoutCache::get_set_layout(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+                                 VkDescriptorSetLayout *layout_ptr) {
+    std::vector<VkDescriptorSetLayoutBinding> sorted = bindings;
+
+    std::sort(sorted.begin(), sorted.end(),
+              [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+                  return a.binding < b.binding;
+              });
+
+    LayoutKey key{};
+    key.reserve(sorted.size() * 2);
+
+    for(const VkDescriptorSetLayoutBinding &binding : sorted) {
+        key.push_back(static_cast<uint64_t>(binding.binding) << 32 | static_cast<uint32_t>(binding.descriptorType));
+        key.push_back(static_cast<uint64_t>(binding.descriptorCount) << 32 | binding.stageFlags);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto found = _set_layouts.find(key);
+
+    if(found != _set_layouts.end()) {
+        *layout_ptr = found->second;
+        return true;
+    }
+
+    VkDescriptorSetLayoutCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    create_info.bindingCount = static_cast<uint32_t>(sorted.size());
+    create_info.pBindings = sorted.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+
+    if(vkCreateDescriptorSetLayout(_logical_device, &create_info, nullptr, &layout) != VK_SUCCESS) {
+        spdlog::error("[LayoutCache] failed to create descriptor set layout");
+        return false;
+    }
+
+    _set_layouts.emplace(std::move(key), layout);
+    *layout_ptr = layout;
+
+    return true;
+}
+
+bool LayoutCache::get_pipeline_layout(const ShaderReflection &reflection, PipelineLayoutInfo *info_ptr) {
+    std::vector<VkDescriptorSetLayout> reserved_sets{};
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        reserved_sets = _reserved_sets;
+    }
+
+    // reserved sets are part of every layout, so the sets before them always line up
+    uint32_t set_count = static_cast<uint32_t>(reserved_sets.size());
+
+    for(const ReflectedBinding &binding : reflection.bindings)
+        set_count = std::max(set_count, binding.set + 1);
+
+    auto is_reserved = [&reserved_sets](uint32_t set) {
+        return set < reserved_sets.size() && reserved_sets[set] != VK_NULL_HANDLE;
+    };
+
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> set_bindings(set_count);
+
+    for(const ReflectedBinding &binding : reflection.bindings) {
+        if(is_reserved(binding.set))
+            continue;
+
+        if(binding.unsized) {
+            spdlog::error("[LayoutCache] set {} binding {} is a runtime array outside of a reserved set",
+                          binding.set, binding.binding);
+            return false;
+        }
+
+        VkDescriptorSetLayoutBinding layout_binding{};
+        layout_binding.binding         = binding.binding;
+        layout_binding.descriptorType  = binding.type;
+        layout_binding.descriptorCount = binding.count;
+        layout_binding.stageFlags      = binding.stages;
+
+        set_bindings[binding.set].push_back(layout_binding);
+    }
+
+    PipelineLayoutInfo info{};
+    info.set_layouts.resize(set_count);
+
+    for(uint32_t set = 0; set < set_count; set++) {
+        if(is_reserved(set)) {
+            info.set_layouts[set] = reserved_sets[set];
+            continue;
+        }
+
+        if(get_set_layout(set_bindings[set], &info.set_layouts[set]) == false)
+            return false;
+    }
+
+    // set layouts are deduplicated already, so their handles identify them
+    LayoutKey key{};
+    key.reserve(set_count + 2);
+
+    for(VkDescriptorSetLayout set_layout : info.set_layouts)
+        key.push_back(reinterpret_cast<uint64_t>(set_layout));
+
+    const VkPushConstantRange &push_constants = reflection.push_constants;
+
+    key.push_back(static_cast<uint64_t>(push_constants.offset) << 32 | push_constants.size);
+    key.push_back(push_constants.size != 0 ? push_constants.stageFlags : 0);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto found = _pipeline_layouts.find(key);
+
+    if(found != _pipeline_layouts.end()) {
+        *info_ptr = found->second;
+        return true;
+    }
+
+    VkPipelineLayoutCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    create_info.setLayoutCount = set_count;
+    create_info.pSetLayouts = info.set_layouts.data();
+
+    if(push_constants.size != 0) {
+        create_info.pushConstantRangeCount = 1;
+        create_info.pPushConstantRanges = &push_constants;
+    }
+
+    if(vkCreatePipelineLayout(_logical_device, &create_info, nullptr, &info.layout) != VK_SUCCESS) {
+        spdlog::error("[LayoutCache] failed to create pipeline layout");
+        return false;
+    }
+
+    spdlog::info("[LayoutCache] created pipeline layout with {} sets and {} bytes of push constants",
+                 set_count, push_constants.size);
+
+    _pipeline_layouts.emplace(std::move(key), info);
+    *info_ptr = info;
+
+    return true;
+}
+
+void LayoutCache::reserve_set(uint32_t set, VkDescriptorSetLayout layout) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if(_reserved_sets.size() <= set)
+        _reserved_sets.resize(set + 1, VK_NULL_HANDLE);
+
+    _reserved_sets[set] = layout;
+}
+
+uint32_t LayoutCache::get_set_layout_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return static_cast<uint32_t>(_set_layouts.size());
+}
+
+uint32_t LayoutCache::get_pipeline_layout_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return static_cast<uint32_t>(_pipeline_layouts.size());
+}
+
+} // namespace fl
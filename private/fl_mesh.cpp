@@ -0,0 +1,92 @@
+#include <fl_mesh.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+Mesh::Mesh() {
+}
+
+Mesh::~Mesh() {
+    destroy();
+}
+
+bool Mesh::init(VkDevice logical, GpuAllocator *allocator_ptr, UploadService *upload_ptr,
+                const void *vertices, uint32_t vertex_count, uint32_t vertex_stride,
+                const std::vector<uint32_t> &indices) {
+    _logical_device = logical;
+    _allocator_ptr  = allocator_ptr;
+    _vertex_count   = vertex_count;
+    _index_count    = static_cast<uint32_t>(indices.size());
+
+    VkDeviceSize vertex_bytes = static_cast<VkDeviceSize>(vertex_count) * vertex_stride;
+
+    if(upload_ptr->create_device_local_buffer(vertex_bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                              &_vertex_buf, &_vertex_alloc) == false)
+        return false;
+
+    if(upload_ptr->upload(_vertex_buf, 0, vertices, vertex_bytes) == false)
+        return false;
+
+    // 0xffff is left out, it restarts primitives when primitive restart is enabled
+    _index_type = vertex_count < UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    std::vector<uint16_t> short_indices{};
+    const void *index_data = indices.data();
+    VkDeviceSize index_bytes = indices.size() * sizeof(uint32_t);
+
+    if(_index_type == VK_INDEX_TYPE_UINT16) {
+        short_indices.assign(indices.begin(), indices.end());
+
+        index_data  = short_indices.data();
+        index_bytes = short_indices.size() * sizeof(uint16_t);
+    }
+
+    if(upload_ptr->create_device_local_buffer(index_bytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                              &_index_buf, &_index_alloc) == false)
+        return false;
+
+    if(upload_ptr->upload(_index_buf, 0, index_data, index_bytes) == false)
+        return false;
+
+    spdlog::info("[Mesh] {} vertices, {} {} bit indices", vertex_count, _index_count,
+                 _index_type == VK_INDEX_TYPE_UINT16 ? 16 : 32);
+
+    return true;
+}
+
+void Mesh::destroy() {
+    if(_allocator_ptr == nullptr)
+        return;
+
+    vkDestroyBuffer(_logical_device, _vertex_buf, nullptr);
+    vkDestroyBuffer(_logical_device, _index_buf, nullptr);
+
+    _allocator_ptr->free(&_vertex_alloc);
+    _allocator_ptr->free(&_index_alloc);
+
+    _vertex_buf = VK_NULL_HANDLE;
+    _index_buf  = VK_NULL_HANDLE;
+    _allocator_ptr = nullptr;
+}
+
+void Mesh::bind(VkCommandBuffer cmd_buf) const {
+    VkDeviceSize vertex_offset = 0;
+
+    vkCmdBindVertexBuffers(cmd_buf, 0, 1, &_vertex_buf, &vertex_offset);
+    vkCmdBindIndexBuffer(cmd_buf, _index_buf, 0, _index_type);
+}
+
+uint32_t Mesh::get_index_count() const {
+    return _index_count;
+}
+
+uint32_t Mesh::get_vertex_count() const {
+    return _vertex_count;
+}
+
+VkIndexType Mesh::get_index_type() const {
+    return _index_type;
+}
+
+} // namespace fl
@@ -0,0 +1,188 @@
+#include <fl_mesh_builder.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace fl {
+
+#define INVALID_TRIANGLE UINT32_MAX
+
+uint64_t hash_vertex_bytes(const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t*>(data);
+
+    uint64_t hash = 14695981039346656037ull;
+
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// favours vertices that are in the cache and vertices with few triangles left, so no vertex is left stranded
+static float vertex_score(int32_t cache_pos, uint32_t remaining_triangles) {
+    if(remaining_triangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    // the vertices of the last triangle get a fixed score, so the strip does not immediately turn back on itself
+    if(cache_pos >= 0 && cache_pos < 3)
+        score = 0.75f;
+    else if(cache_pos >= 3) {
+        float scale = 1.0f / static_cast<float>(VERTEX_CACHE_SIZE - 3);
+        score = std::pow(1.0f - static_cast<float>(cache_pos - 3) * scale, 1.5f);
+    }
+
+    return score + 2.0f / std::sqrt(static_cast<float>(remaining_triangles));
+}
+
+void optimize_vertex_cache(uint32_t *indices, size_t index_count, size_t vertex_count) {
+    size_t tri_count = index_count / 3;
+
+    if(tri_count == 0)
+        return;
+
+    // triangles using each vertex, the first remaining[v] entries of a vertex are the ones not yet emitted
+    std::vector<uint32_t> remaining(vertex_count, 0);
+
+    for(size_t i = 0; i < tri_count * 3; i++)
+        remaining[indices[i]]++;
+
+    std::vector<uint32_t> adj_offsets(vertex_count + 1, 0);
+
+    for(size_t v = 0; v < vertex_count; v++)
+        adj_offsets[v + 1] = adj_offsets[v] + remaining[v];
+
+    std::vector<uint32_t> adj(tri_count * 3);
+    std::vector<uint32_t> fill(adj_offsets.begin(), adj_offsets.end() - 1);
+
+    for(size_t t = 0; t < tri_count; t++) {
+        for(size_t k = 0; k < 3; k++) {
+            uint32_t v = indices[t * 3 + k];
+            adj[fill[v]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int32_t> cache_pos(vertex_count, -1);
+    std::vector<float> vert_scores(vertex_count);
+
+    for(size_t v = 0; v < vertex_count; v++)
+        vert_scores[v] = vertex_score(-1, remaining[v]);
+
+    auto triangle_score = [&](uint32_t t) {
+        return vert_scores[indices[t * 3]] + vert_scores[indices[t * 3 + 1]] + vert_scores[indices[t * 3 + 2]];
+    };
+
+    std::vector<bool> emitted(tri_count, false);
+
+    uint32_t best_tri = 0;
+    float best_score = -1.0f;
+
+    for(uint32_t t = 0; t < tri_count; t++) {
+        float score = triangle_score(t);
+
+        if(score > best_score) {
+            best_score = score;
+            best_tri = t;
+        }
+    }
+
+    std::vector<uint32_t> output{};
+    output.reserve(tri_count * 3);
+
+    std::vector<uint32_t> cache{}, new_cache{};
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    new_cache.reserve(VERTEX_CACHE_SIZE + 3);
+
+    size_t scan_cursor = 0;
+
+    for(size_t emitted_count = 0; emitted_count < tri_count; emitted_count++) {
+        // nothing in the cache touches a live triangle, continue with the next one in the original order
+        if(best_tri == INVALID_TRIANGLE) {
+            while(emitted[scan_cursor])
+                scan_cursor++;
+
+            best_tri = static_cast<uint32_t>(scan_cursor);
+        }
+
+        emitted[best_tri] = true;
+
+        const uint32_t *tri = &indices[best_tri * 3];
+        output.insert(output.end(), tri, tri + 3);
+
+        new_cache.clear();
+
+        for(size_t k = 0; k < 3; k++) {
+            uint32_t v = tri[k];
+
+            uint32_t *live_begin = &adj[adj_offsets[v]];
+            uint32_t *live_end   = live_begin + remaining[v];
+            uint32_t *found      = std::find(live_begin, live_end, best_tri);
+
+            std::swap(*found, *(live_end - 1));
+            remaining[v]--;
+
+            if(std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+                new_cache.push_back(v);
+        }
+
+        for(uint32_t v : cache) {
+            if(std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+                new_cache.push_back(v);
+        }
+
+        // rescore every vertex whose cache position changed, including the ones falling out of the cache
+        for(size_t i = 0; i < new_cache.size(); i++) {
+            uint32_t v = new_cache[i];
+
+            cache_pos[v]   = i < VERTEX_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            vert_scores[v] = vertex_score(cache_pos[v], remaining[v]);
+        }
+
+        best_tri = INVALID_TRIANGLE;
+        best_score = -1.0f;
+
+        for(uint32_t v : new_cache) {
+            for(uint32_t i = 0; i < remaining[v]; i++) {
+                uint32_t t = adj[adj_offsets[v] + i];
+                float score = triangle_score(t);
+
+                if(score > best_score) {
+                    best_score = score;
+                    best_tri = t;
+                }
+            }
+        }
+
+        new_cache.resize(std::min<size_t>(new_cache.size(), VERTEX_CACHE_SIZE));
+        std::swap(cache, new_cache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+float get_acmr(const uint32_t *indices, size_t index_count, size_t vertex_count) {
+    size_t tri_count = index_count / 3;
+
+    if(tri_count == 0)
+        return 0.0f;
+
+    // fifo like most hardware, a vertex stays cached for VERTEX_CACHE_SIZE misses after it was loaded
+    std::vector<size_t> loaded_at(vertex_count, 0);
+    size_t misses = 0;
+
+    for(size_t i = 0; i < tri_count * 3; i++) {
+        uint32_t v = indices[i];
+
+        if(loaded_at[v] == 0 || misses - loaded_at[v] >= VERTEX_CACHE_SIZE) {
+            misses++;
+            loaded_at[v] = misses;
+        }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(tri_count);
+}
+
+} // namespace fl
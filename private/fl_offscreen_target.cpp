@@ -0,0 +1,79 @@
+#include <fl_offscreen_target.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+OffscreenTarget::OffscreenTarget() {
+}
+
+OffscreenTarget::~OffscreenTarget() {
+    destroy();
+}
+
+bool OffscreenTarget::init(VkDevice device, GpuAllocator *allocator_ptr,
+                           VkFormat format, VkExtent2D extent, uint32_t img_count) {
+    _logical_device = device;
+    _allocator_ptr  = allocator_ptr;
+    _img_fmt        = format;
+    _img_extent     = extent;
+
+    _imgs.resize(img_count, VK_NULL_HANDLE);
+    _img_allocs.resize(img_count);
+
+    for(uint32_t i = 0; i < img_count; i++) {
+        if(create_image(&_imgs[i], &_img_allocs[i]) == false) {
+            spdlog::error("[OffscreenTarget] failed to create offscreen image {}", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool OffscreenTarget::create_image(VkImage *img_ptr, GpuAllocation *alloc_ptr) {
+    VkImageCreateInfo img_info{};
+    img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    img_info.imageType = VK_IMAGE_TYPE_2D;
+    img_info.format = _img_fmt;
+    img_info.extent = { _img_extent.width, _img_extent.height, 1 };
+    img_info.mipLevels = 1;
+    img_info.arrayLayers = 1;
+    img_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    img_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // transfer source so that the rendered result can still be copied out for inspection
+    img_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    img_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    img_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if(vkCreateImage(_logical_device, &img_info, nullptr, img_ptr) != VK_SUCCESS)
+        return false;
+
+    return _allocator_ptr->alloc_image(*img_ptr, img_info.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, alloc_ptr);
+}
+
+void OffscreenTarget::destroy() {
+    for(size_t i = 0; i < _imgs.size(); i++) {
+        vkDestroyImage(_logical_device, _imgs[i], nullptr);
+        _allocator_ptr->free(&_img_allocs[i]);
+    }
+
+    _imgs.clear();
+    _img_allocs.clear();
+}
+
+VkFormat OffscreenTarget::get_img_format() const {
+    return _img_fmt;
+}
+
+VkExtent2D OffscreenTarget::get_img_extent() const {
+    return _img_extent;
+}
+
+uint32_t OffscreenTarget::get_images(std::vector<VkImage> *imgs_ptr) {
+    *imgs_ptr = _imgs;
+
+    return static_cast<uint32_t>(_imgs.size());
+}
+
+} // namespace fl
@@ -0,0 +1,32 @@
+#include <fl_opaque_queue.hpp>
+
+#include <algorithm>
+
+namespace fl {
+
+OpaqueQueue::OpaqueQueue() {
+}
+
+void OpaqueQueue::clear() {
+    _draws.clear();
+}
+
+void OpaqueQueue::push(const OpaqueDraw &draw) {
+    _draws.push_back(draw);
+}
+
+void OpaqueQueue::sort_front_to_back() {
+    std::stable_sort(_draws.begin(), _draws.end(), [](const OpaqueDraw &a, const OpaqueDraw &b) {
+        return a.depth < b.depth;
+    });
+}
+
+uint32_t OpaqueQueue::get_count() const {
+    return static_cast<uint32_t>(_draws.size());
+}
+
+const OpaqueDraw* OpaqueQueue::get_draws_ptr() const {
+    return _draws.data();
+}
+
+} // namespace fl
@@ -0,0 +1,141 @@
+#include <fl_parallel_recorder.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <future>
+
+namespace fl {
+
+ParallelRecorder::ParallelRecorder() {
+}
+
+ParallelRecorder::~ParallelRecorder() {
+    destroy();
+}
+
+bool ParallelRecorder::init(VkDevice logical, uint32_t queue_family_idx, ThreadPool *pool_ptr, uint32_t frame_count) {
+    _logical_device = logical;
+    _pool_ptr       = pool_ptr;
+    _max_task_count = pool_ptr->get_thread_count() + 1;
+
+    _slots.resize(frame_count * _max_task_count);
+
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // only ever reset as a whole
+    pool_info.queueFamilyIndex = queue_family_idx;
+
+    for(TaskSlot &slot : _slots) {
+        if(vkCreateCommandPool(logical, &pool_info, nullptr, &slot.pool) != VK_SUCCESS)
+            return false;
+    }
+
+    spdlog::info("[ParallelRecorder] up to {} recording tasks per frame", _max_task_count);
+
+    return true;
+}
+
+void ParallelRecorder::destroy() {
+    // destroying a pool frees every command buffer allocated from it
+    for(TaskSlot &slot : _slots)
+        vkDestroyCommandPool(_logical_device, slot.pool, nullptr);
+
+    _slots.clear();
+}
+
+void ParallelRecorder::begin_frame(size_t frame_idx) {
+    for(uint32_t i = 0; i < _max_task_count; i++) {
+        TaskSlot &slot = _slots[frame_idx * _max_task_count + i];
+
+        if(slot.used == 0)
+            continue;
+
+        vkResetCommandPool(_logical_device, slot.pool, 0);
+        slot.used = 0;
+    }
+}
+
+bool ParallelRecorder::record(size_t frame_idx, const VkCommandBufferInheritanceInfo &inheritance,
+                              uint32_t item_count, const RecordRangeFunc &record_func,
+                              std::vector<VkCommandBuffer> *secondaries_ptr) {
+    uint32_t task_count = (item_count + MIN_RECORD_ITEMS_PER_TASK - 1) / MIN_RECORD_ITEMS_PER_TASK;
+    task_count = std::clamp(task_count, 1u, _max_task_count);
+
+    secondaries_ptr->resize(task_count);
+
+    // command buffers are handed out here on the calling thread, each task then only touches its own
+    for(uint32_t i = 0; i < task_count; i++) {
+        if(acquire_cmd_buf(&_slots[frame_idx * _max_task_count + i], &(*secondaries_ptr)[i]) == false)
+            return false;
+    }
+
+    VkCommandBufferInheritanceInfo inheritance_copy = inheritance;
+
+    auto record_task = [&record_func, inheritance_copy](VkCommandBuffer cmd_buf, uint32_t first, uint32_t count) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                           VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo = &inheritance_copy;
+
+        if(vkBeginCommandBuffer(cmd_buf, &begin_info) != VK_SUCCESS)
+            return false;
+
+        record_func(cmd_buf, first, count);
+
+        return vkEndCommandBuffer(cmd_buf) == VK_SUCCESS;
+    };
+
+    auto range_first = [item_count, task_count](uint32_t task_idx) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(item_count) * task_idx / task_count);
+    };
+
+    std::vector<std::future<bool>> results{};
+    results.reserve(task_count - 1);
+
+    for(uint32_t i = 1; i < task_count; i++) {
+        VkCommandBuffer cmd_buf = (*secondaries_ptr)[i];
+        uint32_t first = range_first(i);
+        uint32_t count = range_first(i + 1) - first;
+
+        results.push_back(_pool_ptr->submit([&record_task, cmd_buf, first, count]() {
+            return record_task(cmd_buf, first, count);
+        }));
+    }
+
+    // the calling thread records the first range instead of idling
+    bool success = record_task((*secondaries_ptr)[0], 0, range_first(1));
+
+    for(std::future<bool> &result : results)
+        success = result.get() && success;
+
+    return success;
+}
+
+uint32_t ParallelRecorder::get_max_task_count() const {
+    return _max_task_count;
+}
+
+bool ParallelRecorder::acquire_cmd_buf(TaskSlot *slot_ptr, VkCommandBuffer *cmd_buf_ptr) {
+    if(slot_ptr->used == slot_ptr->cmd_bufs.size()) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = slot_ptr->pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        alloc_info.commandBufferCount = 1;
+
+        VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+
+        if(vkAllocateCommandBuffers(_logical_device, &alloc_info, &cmd_buf) != VK_SUCCESS)
+            return false;
+
+        slot_ptr->cmd_bufs.push_back(cmd_buf);
+    }
+
+    *cmd_buf_ptr = slot_ptr->cmd_bufs[slot_ptr->used++];
+
+    return true;
+}
+
+} // namespace fl
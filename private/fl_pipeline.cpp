@@ -1,5 +1,4 @@
 #include <fl_pipeline.hpp>
-#include <fl_shader_utils.hpp>
 #include <fl_swapchain.hpp>
 
 #include <stdio.h>
@@ -9,29 +8,27 @@
 
 namespace fl {
 
-Pipeline::Pipeline(const std::string &vert_path, const std::string &frag_path)
-    : _vert_path(vert_path), _frag_path(frag_path) {
+Pipeline::Pipeline(const std::string &vert_path, const std::string &frag_path, const VertexInputDesc &vertex_input)
+    : _vert_path(vert_path), _frag_path(frag_path), _vertex_input(vertex_input) {
 }
 
 Pipeline::~Pipeline() {
-    vkDestroyPipelineLayout(_logical_device, _layout, nullptr);
     vkDestroyPipeline(_logical_device, _graphics, nullptr);
 }
 
-bool Pipeline::init(VkDevice logical, Swapchain *swap_chain_ptr, VkRenderPass render_pass,
-                    VkViewport *p_viewport, VkRect2D *p_scissor) {
+bool Pipeline::init(VkDevice logical, Swapchain *swap_chain_ptr, VkRenderPass render_pass, VkFormat color_format,
+                    VkFormat depth_format, bool depth_test, VkViewport *p_viewport, VkRect2D *p_scissor,
+                    ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr, VkPipelineCache cache) {
     _logical_device = logical;
     _swap_chain_ptr = swap_chain_ptr;
 
-    VkPipelineLayoutCreateInfo layout_create_info{};
-    layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-    if(vkCreatePipelineLayout(logical, &layout_create_info, nullptr, &_layout) != VK_SUCCESS) {
+    if(create_layout(shader_library_ptr, layout_cache_ptr) == false) {
         fprintf(stderr, "[Pipeline] failed to create pipeline layout\n");
         return false;
     }
 
-    if(create_graphics(render_pass, _vert_path, _frag_path) == false) {
+    if(create_graphics(render_pass, color_format, depth_format, depth_test, cache, shader_library_ptr,
+                       _vert_path, _frag_path) == false) {
         fprintf(stderr, "[Pipeline] failed create graphics pipeline\n");
         return false;
     }
@@ -42,44 +39,70 @@ bool Pipeline::init(VkDevice logical, Swapchain *swap_chain_ptr, VkRenderPass re
     return true;
 }
 
+bool Pipeline::create_layout(ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr) {
+    VkShaderModule vert_module = VK_NULL_HANDLE;
+    ShaderReflection vert_reflection{};
+    if(shader_library_ptr->get_module(_vert_path, &vert_module, &vert_reflection) == false)
+        return false;
 
-bool Pipeline::create_graphics(VkRenderPass render_pass,
-                               const std::string &vert_path, const std::string &frag_path) {
-    std::vector<char> vert_shader{};
-    std::vector<char> frag_shader{};
+    VkShaderModule frag_module = VK_NULL_HANDLE;
+    ShaderReflection frag_reflection{};
+    if(shader_library_ptr->get_module(_frag_path, &frag_module, &frag_reflection) == false)
+        return false;
 
-    if(read_compiled_shader(vert_path, &vert_shader) == false)
+    _reflection = ShaderReflection{};
+
+    if(merge_shader_reflection(vert_reflection, &_reflection) == false ||
+       merge_shader_reflection(frag_reflection, &_reflection) == false)
         return false;
 
-    if(read_compiled_shader(frag_path, &frag_shader) == false)
+    check_vertex_inputs();
+
+    PipelineLayoutInfo layout_info{};
+    if(layout_cache_ptr->get_pipeline_layout(_reflection, &layout_info) == false)
         return false;
 
-    spdlog::info("[Pipeline] Vertex Shader Code Size: {0}", vert_shader.size());
-    spdlog::info("[Pipeline] Fragment Shader Code Size: {0}", frag_shader.size());
+    _layout      = layout_info.layout;
+    _set_layouts = layout_info.set_layouts;
+
+    return true;
+}
+
+void Pipeline::check_vertex_inputs() const {
+    for(const ReflectedInput &input : _reflection.inputs) {
+        bool fed = false;
+
+        for(const VkVertexInputAttributeDescription &attr : _vertex_input.attrs)
+            fed = fed || attr.location == input.location;
+
+        if(fed == false)
+            spdlog::warn("[Pipeline] {} reads location {}, but no vertex attribute provides it",
+                         _vert_path, input.location);
+    }
+}
 
+bool Pipeline::create_graphics(VkRenderPass render_pass, VkFormat color_format, VkFormat depth_format,
+                               bool depth_test, VkPipelineCache cache,
+                               ShaderLibrary *shader_library_ptr,
+                               const std::string &vert_path, const std::string &frag_path) {
+    // owned by the library, so they are not destroyed once the pipeline is created
     VkShaderModule vert_module = VK_NULL_HANDLE;
-    if(create_shader_module(&vert_shader, &vert_module) == false)
+    if(shader_library_ptr->get_module(vert_path, &vert_module) == false)
         return false;
-    spdlog::info("[Pipeline] Vertex Shader Module created");
-
 
     VkShaderModule frag_module = VK_NULL_HANDLE;
-    if(create_shader_module(&frag_shader, &frag_module) == false)
+    if(shader_library_ptr->get_module(frag_path, &frag_module) == false)
         return false;
-    spdlog::info("[Pipeline] Fragment Shader Module created");
 
     
     // PROGRAMMABLE FUNCTION STAGES
     VkPipelineVertexInputStateCreateInfo vert_input_state{};
     vert_input_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    auto bind_desc = Vertex::get_binding_desc();
-    auto attr_descs = Vertex::get_attr_descs();
+    vert_input_state.vertexBindingDescriptionCount = static_cast<uint32_t>(_vertex_input.bindings.size());
+    vert_input_state.pVertexBindingDescriptions = _vertex_input.bindings.data();
 
-    vert_input_state.vertexBindingDescriptionCount = 1;
-    vert_input_state.pVertexBindingDescriptions = &bind_desc;
-
-    vert_input_state.vertexAttributeDescriptionCount = static_cast<uint32_t>(attr_descs.size());
-    vert_input_state.pVertexAttributeDescriptions = attr_descs.data();
+    vert_input_state.vertexAttributeDescriptionCount = static_cast<uint32_t>(_vertex_input.attrs.size());
+    vert_input_state.pVertexAttributeDescriptions = _vertex_input.attrs.data();
 
     VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
     vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -130,6 +153,16 @@ bool Pipeline::create_graphics(VkRenderPass render_pass,
     multisample_state.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
 
+    // pipelines without the test still need the state inside a pass with a depth attachment, they draw over everything
+    VkPipelineDepthStencilStateCreateInfo depth_state{};
+    depth_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depth_state.depthTestEnable  = depth_test ? VK_TRUE : VK_FALSE;
+    depth_state.depthWriteEnable = depth_test ? VK_TRUE : VK_FALSE;
+    depth_state.depthCompareOp = VK_COMPARE_OP_LESS; // layers at the same depth keep the first one drawn
+    depth_state.depthBoundsTestEnable = VK_FALSE;
+    depth_state.stencilTestEnable = VK_FALSE;
+
+
     VkPipelineColorBlendAttachmentState color_blend_attachment{};
     color_blend_attachment.colorWriteMask =
         VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
@@ -161,7 +194,7 @@ bool Pipeline::create_graphics(VkRenderPass render_pass,
 
     pipeline_info.pInputAssemblyState = &in_assembly_state;
 
-    pipeline_info.pDepthStencilState = nullptr;
+    pipeline_info.pDepthStencilState = depth_format != VK_FORMAT_UNDEFINED ? &depth_state : nullptr;
     pipeline_info.pRasterizationState = &raster_state;
     pipeline_info.pMultisampleState = &multisample_state;
 
@@ -172,33 +205,38 @@ bool Pipeline::create_graphics(VkRenderPass render_pass,
     pipeline_info.renderPass = render_pass;
     pipeline_info.subpass = 0;
 
+    // only read when there is no render pass, the attachment formats stand in for it
+    VkPipelineRenderingCreateInfoKHR rendering_info{};
+    rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    rendering_info.colorAttachmentCount = 1;
+    rendering_info.pColorAttachmentFormats = &color_format;
+    rendering_info.depthAttachmentFormat = depth_format;
+
+    if(render_pass == VK_NULL_HANDLE)
+        pipeline_info.pNext = &rendering_info;
+
 
     pipeline_info.basePipelineHandle = nullptr;
     pipeline_info.basePipelineIndex = -1;
 
-    if(vkCreateGraphicsPipelines(_logical_device, VK_NULL_HANDLE,
-                                 1, &pipeline_info, nullptr, &_graphics) != VK_SUCCESS) {
-        vkDestroyShaderModule(_logical_device, vert_module, nullptr);
-        vkDestroyShaderModule(_logical_device, frag_module, nullptr);
-        return false;
-    }
+    return vkCreateGraphicsPipelines(_logical_device, cache,
+                                     1, &pipeline_info, nullptr, &_graphics) == VK_SUCCESS;
+}
 
-    vkDestroyShaderModule(_logical_device, vert_module, nullptr);
-    vkDestroyShaderModule(_logical_device, frag_module, nullptr);
-    return true;
+VkPipeline Pipeline::get_raw_graphics_handle() const {
+    return _graphics;
 }
 
-bool Pipeline::create_shader_module(const std::vector<char> *shader_code_ptr, VkShaderModule *module_ptr) {
-    VkShaderModuleCreateInfo create_info{};
-    create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    create_info.codeSize = shader_code_ptr->size();
-    create_info.pCode = reinterpret_cast<const uint32_t*>(shader_code_ptr->data());
+VkPipelineLayout Pipeline::get_raw_layout_handle() const {
+    return _layout;
+}
 
-    return vkCreateShaderModule(_logical_device, &create_info, nullptr, module_ptr) == VK_SUCCESS;
+VkDescriptorSetLayout Pipeline::get_raw_set_layout_handle(uint32_t set) const {
+    return set < _set_layouts.size() ? _set_layouts[set] : VK_NULL_HANDLE;
 }
 
-VkPipeline Pipeline::get_raw_graphics_handle() const {
-    return _graphics;
+const ShaderReflection& Pipeline::get_reflection() const {
+    return _reflection;
 }
 
 } // namespace fl
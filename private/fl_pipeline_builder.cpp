@@ -0,0 +1,72 @@
+#include <fl_pipeline_builder.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+namespace fl {
+
+PipelineBuilder::PipelineBuilder() {
+}
+
+PipelineBuilder::~PipelineBuilder() {
+    // the workers write into pipelines owned elsewhere, never leave a build running behind
+    wait_all();
+}
+
+bool PipelineBuilder::init(VkDevice logical, ThreadPool *pool_ptr, ShaderLibrary *shader_library_ptr,
+                           LayoutCache *layout_cache_ptr, VkPipelineCache cache) {
+    _logical_device     = logical;
+    _pool_ptr           = pool_ptr;
+    _shader_library_ptr = shader_library_ptr;
+    _layout_cache_ptr   = layout_cache_ptr;
+    _cache              = cache;
+
+    return true;
+}
+
+std::shared_future<bool> PipelineBuilder::build(const PipelineBuildInfo &info) {
+    VkDevice logical = _logical_device;
+    VkPipelineCache cache = _cache;
+    ShaderLibrary *shader_library_ptr = _shader_library_ptr;
+    LayoutCache *layout_cache_ptr = _layout_cache_ptr;
+
+    std::shared_future<bool> result = _pool_ptr->submit([info, logical, cache, shader_library_ptr, layout_cache_ptr]() {
+        auto start = std::chrono::steady_clock::now();
+
+        bool success = info.pipeline_ptr->init(logical, info.swap_chain_ptr, info.render_pass, info.color_format,
+                                               info.depth_format, info.depth_test, info.viewport_ptr,
+                                               info.scissor_ptr, shader_library_ptr, layout_cache_ptr, cache);
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        spdlog::info("[PipelineBuilder] pipeline built in {:.2f} ms on a worker", elapsed.count());
+
+        return success;
+    }).share();
+
+    _pending.push_back(result);
+
+    return result;
+}
+
+void PipelineBuilder::build_all(const std::vector<PipelineBuildInfo> &infos,
+                                std::vector<std::shared_future<bool>> *results_ptr) {
+    results_ptr->clear();
+    results_ptr->reserve(infos.size());
+
+    for(const PipelineBuildInfo &info : infos)
+        results_ptr->push_back(build(info));
+}
+
+bool PipelineBuilder::wait_all() {
+    bool success = true;
+
+    for(std::shared_future<bool> &pending : _pending)
+        success = pending.get() && success;
+
+    _pending.clear();
+
+    return success;
+}
+
+} // namespace fl
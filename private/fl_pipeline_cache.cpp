@@ -0,0 +1,179 @@
+#include <fl_pipeline_cache.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace fl {
+
+// VkPipelineCacheHeaderVersionOne, every field is stored least significant byte first
+#define CACHE_HEADER_SIZE 32
+
+static uint32_t read_u32_le(const uint8_t *bytes) {
+    return static_cast<uint32_t>(bytes[0])       | static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> *data_ptr) {
+    std::ifstream file{ path, std::ios::ate | std::ios::binary };
+
+    if(file.is_open() == false)
+        return false;
+
+    size_t file_size = static_cast<size_t>(file.tellg());
+
+    data_ptr->resize(file_size);
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data_ptr->data()), file_size);
+
+    return file.good();
+}
+
+// the data has to reach the disk before the rename, otherwise a crash can still leave an empty file behind
+static bool write_file_synced(const std::string &path, const std::vector<uint8_t> &data) {
+    FILE *file = fopen(path.c_str(), "wb");
+
+    if(file == nullptr)
+        return false;
+
+    bool success = fwrite(data.data(), 1, data.size(), file) == data.size() && fflush(file) == 0;
+
+#ifdef _WIN32
+    success = success && _commit(_fileno(file)) == 0;
+#else
+    success = success && fsync(fileno(file)) == 0;
+#endif
+
+    return fclose(file) == 0 && success;
+}
+
+PipelineCache::PipelineCache() {
+}
+
+PipelineCache::~PipelineCache() {
+    destroy();
+}
+
+bool PipelineCache::init(VkPhysicalDevice physical, VkDevice logical, const std::string &path) {
+    _logical_device = logical;
+    _path = path;
+
+    vkGetPhysicalDeviceProperties(physical, &_device_props);
+
+    std::vector<uint8_t> initial_data{};
+
+    if(read_file(path, &initial_data) == false)
+        spdlog::info("[PipelineCache] no cache found at {}, starting empty", path);
+    else if(is_header_compatible(initial_data) == false) {
+        spdlog::info("[PipelineCache] {} was written by another device or driver, starting empty", path);
+        initial_data.clear();
+    }
+    else
+        spdlog::info("[PipelineCache] loaded {} bytes from {}", initial_data.size(), path);
+
+    VkPipelineCacheCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.initialDataSize = initial_data.size();
+    create_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+
+    if(vkCreatePipelineCache(logical, &create_info, nullptr, &_cache) != VK_SUCCESS) {
+        spdlog::error("[PipelineCache] failed to create pipeline cache");
+        return false;
+    }
+
+    _disk_data = std::move(initial_data);
+
+    return true;
+}
+
+void PipelineCache::destroy() {
+    if(_cache == VK_NULL_HANDLE)
+        return;
+
+    save();
+
+    vkDestroyPipelineCache(_logical_device, _cache, nullptr);
+    _cache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::save() {
+    if(_cache == VK_NULL_HANDLE)
+        return false;
+
+    size_t data_size = 0;
+
+    if(vkGetPipelineCacheData(_logical_device, _cache, &data_size, nullptr) != VK_SUCCESS)
+        return false;
+
+    std::vector<uint8_t> data(data_size);
+
+    if(vkGetPipelineCacheData(_logical_device, _cache, &data_size, data.data()) != VK_SUCCESS)
+        return false;
+
+    data.resize(data_size);
+
+    if(data == _disk_data)
+        return true;
+
+    std::string tmp_path = _path + ".tmp";
+
+    if(write_file_synced(tmp_path, data) == false) {
+        spdlog::error("[PipelineCache] failed to write {}", tmp_path);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    // atomically replaces the old cache on both posix and windows
+    std::error_code err;
+    std::filesystem::rename(tmp_path, _path, err);
+
+    if(err) {
+        spdlog::error("[PipelineCache] failed to replace {}: {}", _path, err.message());
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    spdlog::info("[PipelineCache] saved {} bytes to {}", data.size(), _path);
+
+    _disk_data = std::move(data);
+
+    return true;
+}
+
+VkPipelineCache PipelineCache::get_raw_handle() const {
+    return _cache;
+}
+
+bool PipelineCache::is_header_compatible(const std::vector<uint8_t> &data) const {
+    if(data.size() < CACHE_HEADER_SIZE)
+        return false;
+
+    uint32_t header_size    = read_u32_le(&data[0]);
+    uint32_t header_version = read_u32_le(&data[4]);
+    uint32_t vendor_id      = read_u32_le(&data[8]);
+    uint32_t device_id      = read_u32_le(&data[12]);
+
+    if(header_size < CACHE_HEADER_SIZE || header_size > data.size())
+        return false;
+
+    if(header_version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        return false;
+
+    if(vendor_id != _device_props.vendorID || device_id != _device_props.deviceID)
+        return false;
+
+    // the uuid changes with every driver update, which invalidates everything compiled before
+    return memcmp(&data[16], _device_props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+} // namespace fl
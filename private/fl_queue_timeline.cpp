@@ -0,0 +1,112 @@
+#include <fl_queue_timeline.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+QueueTimeline::QueueTimeline() {
+}
+
+QueueTimeline::~QueueTimeline() {
+    destroy();
+}
+
+bool QueueTimeline::init(VkDevice logical) {
+    _logical_device = logical;
+
+    _wait_semaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(logical, "vkWaitSemaphores"));
+    _get_counter_value = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+        vkGetDeviceProcAddr(logical, "vkGetSemaphoreCounterValue"));
+
+    if(_wait_semaphores == nullptr || _get_counter_value == nullptr) {
+        _wait_semaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+            vkGetDeviceProcAddr(logical, "vkWaitSemaphoresKHR"));
+        _get_counter_value = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+            vkGetDeviceProcAddr(logical, "vkGetSemaphoreCounterValueKHR"));
+    }
+
+    if(_wait_semaphores == nullptr || _get_counter_value == nullptr) {
+        spdlog::error("[QueueTimeline] timeline semaphore entry points are missing");
+        return false;
+    }
+
+    VkSemaphoreTypeCreateInfo type_info{};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo sema_info{};
+    sema_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    sema_info.pNext = &type_info;
+
+    if(vkCreateSemaphore(logical, &sema_info, nullptr, &_semaphore) != VK_SUCCESS) {
+        spdlog::error("[QueueTimeline] failed to create the timeline semaphore");
+        return false;
+    }
+
+    _last_value = 0;
+    _completed_value = 0;
+
+    return true;
+}
+
+void QueueTimeline::destroy() {
+    if(_semaphore == VK_NULL_HANDLE)
+        return;
+
+    // nothing may still signal the semaphore once it is gone
+    wait(_last_value);
+
+    vkDestroySemaphore(_logical_device, _semaphore, nullptr);
+    _semaphore = VK_NULL_HANDLE;
+}
+
+uint64_t QueueTimeline::get_pending_value() const {
+    return _last_value + 1;
+}
+
+void QueueTimeline::commit_value() {
+    _last_value++;
+}
+
+uint64_t QueueTimeline::get_last_value() const {
+    return _last_value;
+}
+
+uint64_t QueueTimeline::get_completed_value() {
+    uint64_t value = 0;
+
+    if(_get_counter_value(_logical_device, _semaphore, &value) == VK_SUCCESS)
+        _completed_value = value;
+
+    return _completed_value;
+}
+
+bool QueueTimeline::is_complete(uint64_t value) {
+    return value <= _completed_value || value <= get_completed_value();
+}
+
+bool QueueTimeline::wait(uint64_t value, uint64_t timeout) {
+    if(value <= _completed_value)
+        return true;
+
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &_semaphore;
+    wait_info.pValues = &value;
+
+    if(_wait_semaphores(_logical_device, &wait_info, timeout) != VK_SUCCESS)
+        return false;
+
+    if(value > _completed_value)
+        _completed_value = value;
+
+    return true;
+}
+
+VkSemaphore QueueTimeline::get_raw_handle() const {
+    return _semaphore;
+}
+
+} // namespace fl
@@ -0,0 +1,631 @@
+#include <fl_render_graph.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace fl {
+
+struct AccessInfo {
+    VkPipelineStageFlags stages;
+    VkAccessFlags        access;
+    VkImageLayout        layout;
+    VkImageUsageFlags    usage; // what a transient used this way has to be created with
+};
+
+static AccessInfo get_access_info(ImageAccess access) {
+    const VkPipelineStageFlags depth_stages =
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    const VkPipelineStageFlags shader_stages =
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+    switch(access) {
+        case ImageAccess::COLOR_ATTACHMENT:
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                     VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+        case ImageAccess::DEPTH_ATTACHMENT:
+            return { depth_stages,
+                     VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+        case ImageAccess::DEPTH_READ:
+            return { depth_stages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                     VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+        case ImageAccess::SAMPLED:
+            return { shader_stages, VK_ACCESS_SHADER_READ_BIT,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+        case ImageAccess::STORAGE_READ:
+            return { shader_stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+        case ImageAccess::STORAGE_WRITE:
+            return { shader_stages, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+        case ImageAccess::TRANSFER_SRC:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+        case ImageAccess::TRANSFER_DST:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+    }
+
+    return { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, VK_IMAGE_LAYOUT_GENERAL, 0 };
+}
+
+// usages a transient attachment may have, anything else needs the contents in actual memory
+static const VkImageUsageFlags ATTACHMENT_USAGES = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+static VkImageAspectFlags get_format_aspect(VkFormat format) {
+    switch(format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+RenderGraph::RenderGraph() {
+}
+
+RenderGraph::~RenderGraph() {
+    destroy();
+}
+
+bool RenderGraph::init(VkDevice logical, GpuAllocator *allocator_ptr) {
+    _logical_device = logical;
+    _allocator_ptr  = allocator_ptr;
+
+    return true;
+}
+
+void RenderGraph::destroy() {
+    if(_logical_device == VK_NULL_HANDLE)
+        return;
+
+    release_transients(nullptr);
+    clear();
+}
+
+void RenderGraph::clear() {
+    _passes.clear();
+    _resources.clear();
+    _exec_order.clear();
+    _pass_barriers.clear();
+    _final_barriers = BarrierBatch{};
+    _alias_slots.clear();
+    _stats = RenderGraphStats{};
+}
+
+RenderResourceId RenderGraph::import_image(const std::string &name, VkImageAspectFlags aspect,
+                                           const ImageState &initial, const ImageState *final_ptr) {
+    Resource resource{};
+    resource.name     = name;
+    resource.aspect   = aspect;
+    resource.imported = true;
+    resource.initial  = initial;
+
+    if(final_ptr != nullptr) {
+        resource.final     = *final_ptr;
+        resource.has_final = true;
+    }
+
+    _resources.push_back(resource);
+
+    return static_cast<RenderResourceId>(_resources.size() - 1);
+}
+
+void RenderGraph::set_imported_image(RenderResourceId resource, VkImage img, VkImageView view) {
+    _resources[resource].img  = img;
+    _resources[resource].view = view;
+}
+
+RenderResourceId RenderGraph::create_image(const std::string &name, const TransientImageDesc &desc) {
+    Resource resource{};
+    resource.name   = name;
+    resource.aspect = get_format_aspect(desc.format);
+    resource.desc   = desc;
+
+    _resources.push_back(resource);
+
+    return static_cast<RenderResourceId>(_resources.size() - 1);
+}
+
+RenderPassId RenderGraph::add_pass(const std::string &name, RecordPassFunc &&record_func) {
+    Pass pass{};
+    pass.name = name;
+    pass.record_func = std::move(record_func);
+
+    _passes.push_back(std::move(pass));
+
+    return static_cast<RenderPassId>(_passes.size() - 1);
+}
+
+void RenderGraph::read(RenderPassId pass, RenderResourceId resource, ImageAccess access) {
+    _passes[pass].uses.push_back({ resource, access, false });
+}
+
+void RenderGraph::write(RenderPassId pass, RenderResourceId resource, ImageAccess access) {
+    _passes[pass].uses.push_back({ resource, access, true });
+}
+
+void RenderGraph::set_side_effects(RenderPassId pass) {
+    _passes[pass].side_effects = true;
+}
+
+bool RenderGraph::compile(DeletionQueue *deletion_queue_ptr) {
+    release_transients(deletion_queue_ptr);
+
+    _stats = RenderGraphStats{};
+    _stats.pass_count = static_cast<uint32_t>(_passes.size());
+
+    cull_passes();
+
+    if(create_transients() == false) {
+        spdlog::error("[RenderGraph] failed to create the transient images");
+        return false;
+    }
+
+    if(compute_barriers() == false)
+        return false;
+
+    spdlog::info("[RenderGraph] {} of {} passes active, {} barrier batches, {} transients ({} lazy) in {} of {} bytes",
+                 _exec_order.size(), _stats.pass_count, _stats.barrier_count, _stats.transient_count,
+                 _stats.lazy_count, _stats.allocated_bytes, _stats.transient_bytes);
+
+    return true;
+}
+
+bool RenderGraph::execute(VkCommandBuffer cmd_buf) {
+    for(size_t i = 0; i < _exec_order.size(); i++) {
+        Pass &pass = _passes[_exec_order[i]];
+
+        record_batch(cmd_buf, _pass_barriers[i]);
+
+        if(pass.record_func(cmd_buf) == false) {
+            spdlog::error("[RenderGraph] recording pass \"{}\" failed", pass.name);
+            return false;
+        }
+    }
+
+    record_batch(cmd_buf, _final_barriers);
+
+    return true;
+}
+
+VkImage RenderGraph::get_image(RenderResourceId resource) const {
+    return _resources[resource].img;
+}
+
+VkImageView RenderGraph::get_view(RenderResourceId resource) const {
+    return _resources[resource].view;
+}
+
+bool RenderGraph::is_pass_active(RenderPassId pass) const {
+    return _passes[pass].active;
+}
+
+const RenderGraphStats* RenderGraph::get_stats_ptr() const {
+    return &_stats;
+}
+
+void RenderGraph::cull_passes() {
+    // outputs are needed by whoever runs after the graph, everything else only when an active pass reads it
+    std::vector<bool> needed(_resources.size(), false);
+
+    for(size_t i = 0; i < _resources.size(); i++)
+        needed[i] = _resources[i].has_final;
+
+    // passes only consume what earlier passes produced, so one walk from the back settles every pass
+    for(size_t i = _passes.size(); i-- > 0;) {
+        Pass &pass = _passes[i];
+        pass.active = pass.side_effects;
+
+        for(const ImageUse &use : pass.uses)
+            pass.active = pass.active || (use.write && needed[use.resource]);
+
+        if(pass.active == false)
+            continue;
+
+        for(const ImageUse &use : pass.uses) {
+            if(use.write == false)
+                needed[use.resource] = true;
+        }
+    }
+
+    _exec_order.clear();
+
+    for(size_t i = 0; i < _passes.size(); i++) {
+        if(_passes[i].active)
+            _exec_order.push_back(static_cast<RenderPassId>(i));
+        else
+            spdlog::info("[RenderGraph] culled pass \"{}\", nothing reads what it writes", _passes[i].name);
+    }
+
+    _stats.culled_pass_count = static_cast<uint32_t>(_passes.size() - _exec_order.size());
+}
+
+bool RenderGraph::create_transients() {
+    std::vector<uint32_t> first_uses(_resources.size(), INVALID_RENDER_ID);
+    std::vector<uint32_t> last_uses(_resources.size(), 0);
+
+    for(uint32_t i = 0; i < _exec_order.size(); i++) {
+        for(const ImageUse &use : _passes[_exec_order[i]].uses) {
+            Resource &resource = _resources[use.resource];
+            resource.usage |= get_access_info(use.access).usage;
+
+            first_uses[use.resource] = std::min(first_uses[use.resource], i);
+            last_uses[use.resource]  = i;
+        }
+    }
+
+    VkDeviceSize transient_bytes = 0;
+
+    for(RenderResourceId id = 0; id < _resources.size(); id++) {
+        Resource &resource = _resources[id];
+
+        // transients only the culled passes touched are never created
+        if(resource.imported || first_uses[id] == INVALID_RENDER_ID)
+            continue;
+
+        // written and read within one pass, so the contents can stay in tile memory and are never stored
+        if(first_uses[id] == last_uses[id] && (resource.usage & ~ATTACHMENT_USAGES) == 0)
+            resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+        VkImageCreateInfo img_info{};
+        img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        img_info.imageType = VK_IMAGE_TYPE_2D;
+        img_info.format = resource.desc.format;
+        img_info.extent = { resource.desc.extent.width, resource.desc.extent.height, 1 };
+        img_info.mipLevels = 1;
+        img_info.arrayLayers = 1;
+        img_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        img_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        img_info.usage = resource.usage;
+        img_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        img_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if(vkCreateImage(_logical_device, &img_info, nullptr, &resource.img) != VK_SUCCESS)
+            return false;
+
+        _transient_imgs.push_back(resource.img);
+        _stats.transient_count++;
+
+        VkMemoryRequirements reqs{};
+        vkGetImageMemoryRequirements(_logical_device, resource.img, &reqs);
+        transient_bytes += reqs.size;
+    }
+
+    _stats.transient_bytes = transient_bytes;
+
+    assign_alias_slots(first_uses, last_uses);
+
+    for(AliasSlot &slot : _alias_slots) {
+        if(_allocator_ptr->alloc_image_memory(slot.reqs, slot.props, &slot.alloc) == false)
+            return false;
+
+        if(slot.props & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+            _stats.lazy_count += static_cast<uint32_t>(slot.resources.size());
+
+        _transient_allocs.push_back(slot.alloc);
+        _stats.allocated_bytes += slot.reqs.size;
+
+        // every image of the slot starts at the same offset, their contents never outlive their pass range
+        for(RenderResourceId id : slot.resources) {
+            if(vkBindImageMemory(_logical_device, _resources[id].img, slot.alloc.memory, slot.alloc.offset) != VK_SUCCESS)
+                return false;
+        }
+    }
+
+    for(Resource &resource : _resources) {
+        if(resource.imported || resource.img == VK_NULL_HANDLE)
+            continue;
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = resource.img;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = resource.desc.format;
+        view_info.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+
+        if(vkCreateImageView(_logical_device, &view_info, nullptr, &resource.view) != VK_SUCCESS)
+            return false;
+
+        _transient_views.push_back(resource.view);
+    }
+
+    return true;
+}
+
+void RenderGraph::assign_alias_slots(const std::vector<uint32_t> &first_uses, const std::vector<uint32_t> &last_uses) {
+    std::vector<RenderResourceId> order{};
+    std::vector<VkMemoryRequirements> reqs(_resources.size());
+
+    for(RenderResourceId id = 0; id < _resources.size(); id++) {
+        if(_resources[id].imported || _resources[id].img == VK_NULL_HANDLE)
+            continue;
+
+        vkGetImageMemoryRequirements(_logical_device, _resources[id].img, &reqs[id]);
+        order.push_back(id);
+    }
+
+    // the largest images open the slots, smaller ones then fit into them
+    std::sort(order.begin(), order.end(), [&reqs](RenderResourceId a, RenderResourceId b) {
+        return reqs[a].size > reqs[b].size;
+    });
+
+    const VkMemoryPropertyFlags lazy_props = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+
+    for(RenderResourceId id : order) {
+        const VkMemoryRequirements &req = reqs[id];
+        AliasSlot *chosen_ptr = nullptr;
+
+        // desktop gpus have no lazily allocated memory, transient attachments live in device local memory there
+        VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        uint32_t lazy_type = 0;
+
+        if((_resources[id].usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) &&
+           _allocator_ptr->find_mem_type(req.memoryTypeBits, lazy_props, &lazy_type))
+            props = lazy_props;
+
+        for(AliasSlot &slot : _alias_slots) {
+            if(slot.props != props || (slot.reqs.memoryTypeBits & req.memoryTypeBits) == 0)
+                continue;
+
+            bool overlaps = false;
+
+            for(size_t i = 0; i < slot.resources.size() && overlaps == false; i++)
+                overlaps = first_uses[id] <= slot.last_uses[i] && slot.first_uses[i] <= last_uses[id];
+
+            if(overlaps == false) {
+                chosen_ptr = &slot;
+                break;
+            }
+        }
+
+        if(chosen_ptr == nullptr) {
+            _alias_slots.push_back(AliasSlot{});
+            chosen_ptr = &_alias_slots.back();
+            chosen_ptr->reqs = req;
+            chosen_ptr->props = props;
+        }
+
+        AliasSlot &slot = *chosen_ptr;
+        slot.reqs.size            = std::max(slot.reqs.size, req.size);
+        slot.reqs.alignment       = std::max(slot.reqs.alignment, req.alignment);
+        slot.reqs.memoryTypeBits &= req.memoryTypeBits;
+
+        slot.resources.push_back(id);
+        slot.first_uses.push_back(first_uses[id]);
+        slot.last_uses.push_back(last_uses[id]);
+
+        _resources[id].alias_slot = static_cast<uint32_t>(&slot - _alias_slots.data());
+    }
+}
+
+bool RenderGraph::compute_barriers() {
+    struct MergedUse {
+        RenderResourceId     resource;
+        VkPipelineStageFlags stages;
+        VkAccessFlags        access;
+        VkImageLayout        layout;
+        bool                 write;
+    };
+
+    // one use per image and pass, a pass may read and write the same image but only in a single layout
+    std::vector<std::vector<MergedUse>> pass_uses(_exec_order.size());
+
+    for(size_t i = 0; i < _exec_order.size(); i++) {
+        const Pass &pass = _passes[_exec_order[i]];
+
+        for(const ImageUse &use : pass.uses) {
+            AccessInfo info = get_access_info(use.access);
+
+            auto found = std::find_if(pass_uses[i].begin(), pass_uses[i].end(),
+                [&use](const MergedUse &merged) { return merged.resource == use.resource; });
+
+            if(found == pass_uses[i].end()) {
+                pass_uses[i].push_back({ use.resource, info.stages, info.access, info.layout, use.write });
+                continue;
+            }
+
+            if(found->layout != info.layout) {
+                spdlog::error("[RenderGraph] pass \"{}\" uses \"{}\" in two layouts", pass.name,
+                              _resources[use.resource].name);
+                return false;
+            }
+
+            found->stages |= info.stages;
+            found->access |= info.access;
+            found->write   = found->write || use.write;
+        }
+    }
+
+    // transients share sync state with the images aliasing their memory, imports have their own
+    auto get_sync_idx = [this](RenderResourceId id) {
+        const Resource &resource = _resources[id];
+        return resource.imported ? id : static_cast<RenderResourceId>(_resources.size() + resource.alias_slot);
+    };
+
+    std::vector<SyncState> slot_start(_alias_slots.size());
+
+    // the first walk finds where every alias slot ends up, the next frame's first use has to wait for that
+    for(int walk = 0; walk < 2; walk++) {
+        bool emit = walk == 1;
+
+        std::vector<VkImageLayout> layouts(_resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+        std::vector<SyncState> sync(_resources.size() + _alias_slots.size());
+
+        for(RenderResourceId id = 0; id < _resources.size(); id++) {
+            const Resource &resource = _resources[id];
+
+            if(resource.imported) {
+                layouts[id] = resource.initial.layout;
+                sync[id].write_stages = resource.initial.stages;
+                sync[id].write_access = resource.initial.access;
+            }
+        }
+
+        for(size_t slot = 0; slot < _alias_slots.size(); slot++)
+            sync[_resources.size() + slot] = slot_start[slot];
+
+        if(emit)
+            _pass_barriers.assign(_exec_order.size(), BarrierBatch{});
+
+        for(size_t i = 0; i < _exec_order.size(); i++) {
+            for(const MergedUse &use : pass_uses[i]) {
+                SyncState &state = sync[get_sync_idx(use.resource)];
+                VkImageLayout &layout = layouts[use.resource];
+
+                bool layout_change = layout != use.layout;
+                bool hazard = layout_change;
+
+                // write after write or after read, the earlier accesses have to finish first
+                if(use.write)
+                    hazard = hazard || (state.write_stages | state.read_stages) != 0;
+                // read after write, unless a barrier already made the write visible to this stage and access
+                else if(state.write_stages != 0)
+                    hazard = hazard || (use.access & ~state.visible_access) != 0 ||
+                                       (use.stages & ~state.visible_stages) != 0;
+
+                if(hazard && emit) {
+                    BarrierBatch &batch = _pass_barriers[i];
+                    VkPipelineStageFlags src_stages = state.write_stages | state.read_stages;
+
+                    batch.src_stages |= src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                    batch.dst_stages |= use.stages;
+                    batch.barriers.push_back({ use.resource, layout, use.layout, state.write_access, use.access });
+                }
+
+                // a layout transition counts as a write, later readers have to wait for it as well
+                if(use.write || layout_change) {
+                    state.write_stages   = use.stages;
+                    state.write_access   = use.write ? use.access : 0;
+                    state.read_stages    = 0;
+                    state.visible_stages = use.stages;
+                    state.visible_access = use.access;
+                }
+                else {
+                    state.read_stages |= use.stages;
+
+                    if(hazard) {
+                        state.visible_stages |= use.stages;
+                        state.visible_access |= use.access;
+                    }
+                }
+
+                layout = use.layout;
+            }
+        }
+
+        if(emit == false) {
+            for(size_t slot = 0; slot < _alias_slots.size(); slot++)
+                slot_start[slot] = sync[_resources.size() + slot];
+
+            continue;
+        }
+
+        _final_barriers = BarrierBatch{};
+
+        for(RenderResourceId id = 0; id < _resources.size(); id++) {
+            const Resource &resource = _resources[id];
+
+            if(resource.has_final == false)
+                continue;
+
+            const SyncState &state = sync[id];
+
+            if(layouts[id] == resource.final.layout && (state.write_access == 0 || resource.final.access == 0))
+                continue;
+
+            VkPipelineStageFlags src_stages = state.write_stages | state.read_stages;
+
+            _final_barriers.src_stages |= src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            _final_barriers.dst_stages |= resource.final.stages;
+            _final_barriers.barriers.push_back({ id, layouts[id], resource.final.layout, state.write_access,
+                                                 resource.final.access });
+        }
+    }
+
+    for(const BarrierBatch &batch : _pass_barriers)
+        _stats.barrier_count += batch.barriers.empty() ? 0 : 1;
+
+    _stats.barrier_count += _final_barriers.barriers.empty() ? 0 : 1;
+
+    return true;
+}
+
+void RenderGraph::release_transients(DeletionQueue *deletion_queue_ptr) {
+    VkDevice logical = _logical_device;
+    GpuAllocator *allocator_ptr = _allocator_ptr;
+
+    auto destroy_func = [logical, allocator_ptr, imgs = _transient_imgs, views = _transient_views,
+                         allocs = _transient_allocs]() mutable {
+        for(VkImageView view : views)
+            vkDestroyImageView(logical, view, nullptr);
+
+        for(VkImage img : imgs)
+            vkDestroyImage(logical, img, nullptr);
+
+        for(GpuAllocation &alloc : allocs)
+            allocator_ptr->free(&alloc);
+    };
+
+    if(_transient_imgs.empty() == false || _transient_allocs.empty() == false) {
+        if(deletion_queue_ptr != nullptr)
+            deletion_queue_ptr->retire(std::move(destroy_func));
+        else
+            destroy_func();
+    }
+
+    _transient_imgs.clear();
+    _transient_views.clear();
+    _transient_allocs.clear();
+    _alias_slots.clear();
+
+    for(Resource &resource : _resources) {
+        if(resource.imported)
+            continue;
+
+        resource.img  = VK_NULL_HANDLE;
+        resource.view = VK_NULL_HANDLE;
+        resource.usage = 0;
+        resource.alias_slot = INVALID_RENDER_ID;
+    }
+}
+
+void RenderGraph::record_batch(VkCommandBuffer cmd_buf, const BarrierBatch &batch) const {
+    if(batch.barriers.empty())
+        return;
+
+    std::vector<VkImageMemoryBarrier> img_barriers(batch.barriers.size());
+
+    for(size_t i = 0; i < batch.barriers.size(); i++) {
+        const Barrier &barrier = batch.barriers[i];
+        const Resource &resource = _resources[barrier.resource];
+
+        VkImageMemoryBarrier &img_barrier = img_barriers[i];
+        img_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        img_barrier.srcAccessMask = barrier.src_access;
+        img_barrier.dstAccessMask = barrier.dst_access;
+        img_barrier.oldLayout = barrier.old_layout;
+        img_barrier.newLayout = barrier.new_layout;
+        img_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        img_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        img_barrier.image = resource.img;
+        img_barrier.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+    }
+
+    VkPipelineStageFlags dst_stages = batch.dst_stages != 0 ? batch.dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+    vkCmdPipelineBarrier(cmd_buf, batch.src_stages, dst_stages, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(img_barriers.size()), img_barriers.data());
+}
+
+} // namespace fl
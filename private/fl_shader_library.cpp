@@ -0,0 +1,123 @@
+#include <fl_shader_library.hpp>
+#include <fl_shader_utils.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+ShaderLibrary::ShaderLibrary() {
+}
+
+ShaderLibrary::~ShaderLibrary() {
+    destroy();
+}
+
+bool ShaderLibrary::init(VkDevice logical) {
+    _logical_device = logical;
+
+    return true;
+}
+
+void ShaderLibrary::destroy() {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for(auto &[key, loaded] : _modules)
+        vkDestroyShaderModule(_logical_device, loaded.module, nullptr);
+
+    _modules.clear();
+    _path_modules.clear();
+}
+
+bool ShaderLibrary::get_module(const std::string &path, VkShaderModule *module_ptr,
+                               ShaderReflection *reflection_ptr) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto found = _path_modules.find(path);
+
+        if(found != _path_modules.end()) {
+            copy_loaded(found->second, module_ptr, reflection_ptr);
+            return true;
+        }
+    }
+
+    // mapping, hashing and module creation happen unlocked, so different shaders load in parallel
+    MappedShader shader{};
+
+    if(map_compiled_shader(path, &shader) == false) {
+        spdlog::error("[ShaderLibrary] failed to map SPIR-V at {}", path);
+        return false;
+    }
+
+    ShaderKey key { hash_shader_code(shader.words, shader.size), shader.size };
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto found = _modules.find(key);
+
+        // the same binary was already loaded under another path
+        if(found != _modules.end()) {
+            unmap_compiled_shader(&shader);
+
+            _path_modules[path] = found->second;
+            copy_loaded(found->second, module_ptr, reflection_ptr);
+            return true;
+        }
+    }
+
+    LoadedShader loaded{};
+
+    if(reflect_shader(shader.words, shader.size, &loaded.reflection) == false) {
+        spdlog::error("[ShaderLibrary] failed to reflect {}", path);
+        unmap_compiled_shader(&shader);
+        return false;
+    }
+
+    VkShaderModuleCreateInfo create_info{};
+    create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    create_info.codeSize = shader.size;
+    create_info.pCode = shader.words;
+
+    VkResult result = vkCreateShaderModule(_logical_device, &create_info, nullptr, &loaded.module);
+
+    // the driver copies the code, the mapping is no longer needed
+    unmap_compiled_shader(&shader);
+
+    if(result != VK_SUCCESS) {
+        spdlog::error("[ShaderLibrary] failed to create shader module for {}", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto [inserted, is_new] = _modules.emplace(key, loaded);
+
+    // another thread created the same module in the meantime, keep theirs
+    if(is_new == false)
+        vkDestroyShaderModule(_logical_device, loaded.module, nullptr);
+    else
+        spdlog::info("[ShaderLibrary] loaded {} ({} bytes, {} descriptor bindings)", path, create_info.codeSize,
+                     loaded.reflection.bindings.size());
+
+    _path_modules[path] = inserted->second;
+    copy_loaded(inserted->second, module_ptr, reflection_ptr);
+
+    return true;
+}
+
+void ShaderLibrary::copy_loaded(const LoadedShader &loaded, VkShaderModule *module_ptr,
+                                ShaderReflection *reflection_ptr) {
+    *module_ptr = loaded.module;
+
+    if(reflection_ptr != nullptr)
+        *reflection_ptr = loaded.reflection;
+}
+
+uint32_t ShaderLibrary::get_module_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return static_cast<uint32_t>(_modules.size());
+}
+
+} // namespace fl
@@ -0,0 +1,545 @@
+#include <fl_shader_reflection.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace fl {
+
+// the handful of SPIR-V enumerants reflection needs, see the SPIR-V specification
+namespace spv {
+    const uint32_t MAGIC = 0x07230203;
+    const uint32_t HEADER_WORDS = 5;
+
+    const uint32_t OP_ENTRY_POINT       = 15;
+    const uint32_t OP_TYPE_INT          = 21;
+    const uint32_t OP_TYPE_FLOAT        = 22;
+    const uint32_t OP_TYPE_VECTOR       = 23;
+    const uint32_t OP_TYPE_MATRIX       = 24;
+    const uint32_t OP_TYPE_IMAGE        = 25;
+    const uint32_t OP_TYPE_SAMPLER      = 26;
+    const uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+    const uint32_t OP_TYPE_ARRAY        = 28;
+    const uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+    const uint32_t OP_TYPE_STRUCT       = 30;
+    const uint32_t OP_TYPE_POINTER      = 32;
+    const uint32_t OP_CONSTANT          = 43;
+    const uint32_t OP_SPEC_CONSTANT     = 50;
+    const uint32_t OP_VARIABLE          = 59;
+    const uint32_t OP_DECORATE          = 71;
+    const uint32_t OP_MEMBER_DECORATE   = 72;
+
+    const uint32_t DECORATION_BLOCK          = 2;
+    const uint32_t DECORATION_BUFFER_BLOCK   = 3;
+    const uint32_t DECORATION_ARRAY_STRIDE   = 6;
+    const uint32_t DECORATION_MATRIX_STRIDE  = 7;
+    const uint32_t DECORATION_BUILT_IN       = 11;
+    const uint32_t DECORATION_LOCATION       = 30;
+    const uint32_t DECORATION_BINDING        = 33;
+    const uint32_t DECORATION_DESCRIPTOR_SET = 34;
+    const uint32_t DECORATION_OFFSET         = 35;
+
+    const uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+    const uint32_t STORAGE_INPUT            = 1;
+    const uint32_t STORAGE_UNIFORM          = 2;
+    const uint32_t STORAGE_PUSH_CONSTANT    = 9;
+    const uint32_t STORAGE_STORAGE_BUFFER   = 12;
+
+    const uint32_t DIM_BUFFER       = 5;
+    const uint32_t DIM_SUBPASS_DATA = 6;
+} // namespace spv
+
+const uint32_t NO_DECORATION = ~0u;
+
+struct SpvDecorations {
+    uint32_t set          = NO_DECORATION;
+    uint32_t binding      = NO_DECORATION;
+    uint32_t location     = NO_DECORATION;
+    uint32_t array_stride = 0;
+
+    bool built_in     = false;
+    bool block        = false;
+    bool buffer_block = false;
+};
+
+struct SpvMemberDecorations {
+    uint32_t offset        = 0;
+    uint32_t matrix_stride = 0;
+};
+
+struct SpvVariable {
+    uint32_t id;
+    uint32_t pointer_type;
+    uint32_t storage;
+};
+
+/// the parts of a module reflection looks at, types keep their whole instruction
+struct SpvModule {
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+
+    std::unordered_map<uint32_t, const uint32_t*> types{};
+    std::unordered_map<uint32_t, uint32_t> constants{};
+
+    std::unordered_map<uint32_t, SpvDecorations> decorations{};
+    std::unordered_map<uint64_t, SpvMemberDecorations> member_decorations{};
+
+    std::vector<SpvVariable> variables{};
+
+    const uint32_t* find_type(uint32_t id) const {
+        auto found = types.find(id);
+        return found != types.end() ? found->second : nullptr;
+    }
+
+    SpvDecorations get_decorations(uint32_t id) const {
+        auto found = decorations.find(id);
+        return found != decorations.end() ? found->second : SpvDecorations{};
+    }
+
+    SpvMemberDecorations get_member_decorations(uint32_t struct_id, uint32_t member) const {
+        auto found = member_decorations.find(static_cast<uint64_t>(struct_id) << 32 | member);
+        return found != member_decorations.end() ? found->second : SpvMemberDecorations{};
+    }
+};
+
+static uint32_t get_op(const uint32_t *inst) {
+    return inst[0] & 0xffffu;
+}
+
+static uint32_t get_word_count(const uint32_t *inst) {
+    return inst[0] >> 16;
+}
+
+// words a type instruction needs for every operand reflection reads from it
+static uint32_t get_min_type_words(uint32_t op) {
+    switch(op) {
+        case spv::OP_TYPE_SAMPLER:
+        case spv::OP_TYPE_STRUCT:        return 2;
+        case spv::OP_TYPE_FLOAT:
+        case spv::OP_TYPE_SAMPLED_IMAGE:
+        case spv::OP_TYPE_RUNTIME_ARRAY: return 3;
+        case spv::OP_TYPE_IMAGE:         return 9;
+        default:                         return 4;
+    }
+}
+
+static bool to_stage(uint32_t execution_model, VkShaderStageFlagBits *stage_ptr) {
+    switch(execution_model) {
+        case 0: *stage_ptr = VK_SHADER_STAGE_VERTEX_BIT;                  return true;
+        case 1: *stage_ptr = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;    return true;
+        case 2: *stage_ptr = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; return true;
+        case 3: *stage_ptr = VK_SHADER_STAGE_GEOMETRY_BIT;                return true;
+        case 4: *stage_ptr = VK_SHADER_STAGE_FRAGMENT_BIT;                return true;
+        case 5: *stage_ptr = VK_SHADER_STAGE_COMPUTE_BIT;                 return true;
+        default: return false;
+    }
+}
+
+static bool parse_module(const uint32_t *words, size_t size, SpvModule *module_ptr) {
+    if(size % sizeof(uint32_t) != 0 || size < spv::HEADER_WORDS * sizeof(uint32_t) || words[0] != spv::MAGIC)
+        return false;
+
+    size_t word_count = size / sizeof(uint32_t);
+    bool found_entry_point = false;
+
+    for(size_t i = spv::HEADER_WORDS; i < word_count;) {
+        const uint32_t *inst = words + i;
+        uint32_t inst_words = get_word_count(inst);
+
+        if(inst_words == 0 || i + inst_words > word_count)
+            return false;
+
+        uint32_t op = get_op(inst);
+
+        switch(op) {
+            case spv::OP_ENTRY_POINT:
+                // only the first entry point counts, the engine always uses main
+                if(found_entry_point == false && inst_words >= 2) {
+                    if(to_stage(inst[1], &module_ptr->stage) == false)
+                        return false;
+
+                    found_entry_point = true;
+                }
+                break;
+
+            case spv::OP_TYPE_INT:
+            case spv::OP_TYPE_FLOAT:
+            case spv::OP_TYPE_VECTOR:
+            case spv::OP_TYPE_MATRIX:
+            case spv::OP_TYPE_IMAGE:
+            case spv::OP_TYPE_SAMPLER:
+            case spv::OP_TYPE_SAMPLED_IMAGE:
+            case spv::OP_TYPE_ARRAY:
+            case spv::OP_TYPE_RUNTIME_ARRAY:
+            case spv::OP_TYPE_STRUCT:
+            case spv::OP_TYPE_POINTER:
+                // a truncated type stays unknown, so the variables using it are skipped rather than read past its end
+                if(inst_words >= get_min_type_words(op))
+                    module_ptr->types[inst[1]] = inst;
+                break;
+
+            case spv::OP_CONSTANT:
+            case spv::OP_SPEC_CONSTANT:
+                // only the low word matters, array lengths never need more
+                if(inst_words >= 4)
+                    module_ptr->constants[inst[2]] = inst[3];
+                break;
+
+            case spv::OP_VARIABLE:
+                if(inst_words >= 4)
+                    module_ptr->variables.push_back(SpvVariable{ inst[2], inst[1], inst[3] });
+                break;
+
+            case spv::OP_DECORATE: {
+                if(inst_words < 3)
+                    break;
+
+                SpvDecorations &decorations = module_ptr->decorations[inst[1]];
+                uint32_t value = inst_words >= 4 ? inst[3] : 0;
+
+                switch(inst[2]) {
+                    case spv::DECORATION_DESCRIPTOR_SET: decorations.set          = value; break;
+                    case spv::DECORATION_BINDING:        decorations.binding      = value; break;
+                    case spv::DECORATION_LOCATION:       decorations.location     = value; break;
+                    case spv::DECORATION_ARRAY_STRIDE:   decorations.array_stride = value; break;
+                    case spv::DECORATION_BUILT_IN:       decorations.built_in     = true;  break;
+                    case spv::DECORATION_BLOCK:          decorations.block        = true;  break;
+                    case spv::DECORATION_BUFFER_BLOCK:   decorations.buffer_block = true;  break;
+                    default: break;
+                }
+                break;
+            }
+
+            case spv::OP_MEMBER_DECORATE: {
+                if(inst_words < 5)
+                    break;
+
+                uint64_t key = static_cast<uint64_t>(inst[1]) << 32 | inst[2];
+
+                if(inst[3] == spv::DECORATION_OFFSET)
+                    module_ptr->member_decorations[key].offset = inst[4];
+                else if(inst[3] == spv::DECORATION_MATRIX_STRIDE)
+                    module_ptr->member_decorations[key].matrix_stride = inst[4];
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        i += inst_words;
+    }
+
+    return found_entry_point;
+}
+
+// bytes a type occupies inside a buffer block, using the explicit strides the compiler decorated it with
+static uint32_t get_type_size(const SpvModule &module, uint32_t type_id, uint32_t matrix_stride = 0) {
+    const uint32_t *type = module.find_type(type_id);
+
+    if(type == nullptr)
+        return 0;
+
+    switch(get_op(type)) {
+        case spv::OP_TYPE_INT:
+        case spv::OP_TYPE_FLOAT:
+            return type[2] / 8;
+
+        case spv::OP_TYPE_VECTOR:
+            return get_type_size(module, type[2]) * type[3];
+
+        case spv::OP_TYPE_MATRIX:
+            return (matrix_stride != 0 ? matrix_stride : get_type_size(module, type[2])) * type[3];
+
+        case spv::OP_TYPE_ARRAY: {
+            auto length = module.constants.find(type[3]);
+            if(length == module.constants.end())
+                return 0;
+
+            uint32_t stride = module.get_decorations(type_id).array_stride;
+            if(stride == 0)
+                stride = get_type_size(module, type[2], matrix_stride);
+
+            return stride * length->second;
+        }
+
+        case spv::OP_TYPE_STRUCT: {
+            uint32_t size = 0;
+
+            for(uint32_t member = 0; member + 2 < get_word_count(type); member++) {
+                SpvMemberDecorations decorations = module.get_member_decorations(type_id, member);
+
+                uint32_t end = decorations.offset + get_type_size(module, type[member + 2], decorations.matrix_stride);
+                size = std::max(size, end);
+            }
+
+            return size;
+        }
+
+        default:
+            // runtime arrays have no static size
+            return 0;
+    }
+}
+
+static bool get_descriptor_type(const SpvModule &module, const uint32_t *type, uint32_t storage,
+                                VkDescriptorType *type_ptr) {
+    switch(get_op(type)) {
+        case spv::OP_TYPE_SAMPLER:
+            *type_ptr = VK_DESCRIPTOR_TYPE_SAMPLER;
+            return true;
+
+        case spv::OP_TYPE_SAMPLED_IMAGE:
+            *type_ptr = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            return true;
+
+        case spv::OP_TYPE_IMAGE: {
+            uint32_t dim     = type[3];
+            uint32_t sampled = type[7]; // 1 read through a sampler, 2 read and written as storage
+
+            if(dim == spv::DIM_BUFFER)
+                *type_ptr = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            else if(dim == spv::DIM_SUBPASS_DATA)
+                *type_ptr = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            else
+                *type_ptr = sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+
+            return true;
+        }
+
+        case spv::OP_TYPE_STRUCT: {
+            // older compilers mark storage buffers as BufferBlock in the uniform storage class
+            SpvDecorations decorations = module.get_decorations(type[1]);
+
+            if(storage == spv::STORAGE_STORAGE_BUFFER || decorations.buffer_block)
+                *type_ptr = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            else
+                *type_ptr = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+static bool get_input_format(const SpvModule &module, uint32_t type_id, VkFormat *format_ptr) {
+    const uint32_t *type = module.find_type(type_id);
+
+    if(type == nullptr)
+        return false;
+
+    uint32_t component_count = 1;
+
+    if(get_op(type) == spv::OP_TYPE_VECTOR) {
+        component_count = type[3];
+        type = module.find_type(type[2]);
+
+        if(type == nullptr)
+            return false;
+    }
+
+    // anything but a scalar, e.g. a struct, has no width operand to read
+    if(get_op(type) != spv::OP_TYPE_FLOAT && get_op(type) != spv::OP_TYPE_INT)
+        return false;
+
+    if(type[2] != 32 || component_count < 1 || component_count > 4)
+        return false;
+
+    const VkFormat float_formats[] = {
+        VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT
+    };
+    const VkFormat sint_formats[] = {
+        VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT
+    };
+    const VkFormat uint_formats[] = {
+        VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT
+    };
+
+    if(get_op(type) == spv::OP_TYPE_FLOAT)
+        *format_ptr = float_formats[component_count - 1];
+    else
+        *format_ptr = type[3] ? sint_formats[component_count - 1] : uint_formats[component_count - 1];
+
+    return true;
+}
+
+static bool reflect_variable(const SpvModule &module, const SpvVariable &variable, ShaderReflection *res_ptr) {
+    const uint32_t *pointer = module.find_type(variable.pointer_type);
+
+    if(pointer == nullptr || get_op(pointer) != spv::OP_TYPE_POINTER)
+        return false;
+
+    uint32_t pointee_id = pointer[3];
+    const uint32_t *pointee = module.find_type(pointee_id);
+
+    SpvDecorations decorations = module.get_decorations(variable.id);
+
+    switch(variable.storage) {
+        case spv::STORAGE_UNIFORM_CONSTANT:
+        case spv::STORAGE_UNIFORM:
+        case spv::STORAGE_STORAGE_BUFFER: {
+            // not a descriptor, e.g. an acceleration structure or a type reflection does not know
+            if(pointee == nullptr || decorations.set == NO_DECORATION || decorations.binding == NO_DECORATION)
+                return true;
+
+            ReflectedBinding binding{};
+            binding.set     = decorations.set;
+            binding.binding = decorations.binding;
+            binding.stages  = res_ptr->stages;
+
+            // arrays of descriptors, nested arrays flatten into one count
+            while(get_op(pointee) == spv::OP_TYPE_ARRAY || get_op(pointee) == spv::OP_TYPE_RUNTIME_ARRAY) {
+                if(get_op(pointee) == spv::OP_TYPE_ARRAY) {
+                    auto length = module.constants.find(pointee[3]);
+                    if(length == module.constants.end())
+                        return false;
+
+                    binding.count *= length->second;
+                }
+                else {
+                    binding.unsized = true;
+                }
+
+                pointee = module.find_type(pointee[2]);
+
+                if(pointee == nullptr)
+                    return false;
+            }
+
+            if(get_descriptor_type(module, pointee, variable.storage, &binding.type) == false) {
+                spdlog::warn("[ShaderReflection] skipping set {} binding {} of an unknown descriptor type",
+                             binding.set, binding.binding);
+                return true;
+            }
+
+            res_ptr->bindings.push_back(binding);
+            return true;
+        }
+
+        case spv::STORAGE_PUSH_CONSTANT: {
+            const uint32_t *block = pointee;
+
+            if(block == nullptr || get_op(block) != spv::OP_TYPE_STRUCT)
+                return false;
+
+            uint32_t first_offset = ~0u;
+
+            for(uint32_t member = 0; member + 2 < get_word_count(block); member++)
+                first_offset = std::min(first_offset, module.get_member_decorations(pointee_id, member).offset);
+
+            uint32_t end = get_type_size(module, pointee_id);
+
+            if(first_offset == ~0u || end <= first_offset)
+                return true;
+
+            res_ptr->push_constants.stageFlags = res_ptr->stages;
+            res_ptr->push_constants.offset     = first_offset;
+            res_ptr->push_constants.size       = (end - first_offset + 3u) & ~3u; // a multiple of 4 as vulkan requires
+            return true;
+        }
+
+        case spv::STORAGE_INPUT: {
+            if(res_ptr->stages != VK_SHADER_STAGE_VERTEX_BIT || decorations.built_in ||
+               decorations.location == NO_DECORATION)
+                return true;
+
+            ReflectedInput input{};
+            input.location = decorations.location;
+
+            if(get_input_format(module, pointee_id, &input.format) == false) {
+                spdlog::warn("[ShaderReflection] vertex input at location {} has a type without a format",
+                             input.location);
+                return true;
+            }
+
+            res_ptr->inputs.push_back(input);
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+bool reflect_shader(const uint32_t *words, size_t size, ShaderReflection *res_ptr) {
+    SpvModule module{};
+
+    if(parse_module(words, size, &module) == false) {
+        spdlog::error("[ShaderReflection] malformed SPIR-V module");
+        return false;
+    }
+
+    *res_ptr = ShaderReflection{};
+    res_ptr->stages = module.stage;
+
+    for(const SpvVariable &variable : module.variables) {
+        if(reflect_variable(module, variable, res_ptr) == false) {
+            spdlog::error("[ShaderReflection] failed to reflect variable %{}", variable.id);
+            return false;
+        }
+    }
+
+    std::sort(res_ptr->bindings.begin(), res_ptr->bindings.end(),
+              [](const ReflectedBinding &a, const ReflectedBinding &b) {
+                  return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+              });
+
+    std::sort(res_ptr->inputs.begin(), res_ptr->inputs.end(),
+              [](const ReflectedInput &a, const ReflectedInput &b) { return a.location < b.location; });
+
+    return true;
+}
+
+bool merge_shader_reflection(const ShaderReflection &stage, ShaderReflection *merged_ptr) {
+    for(const ReflectedBinding &binding : stage.bindings) {
+        auto found = std::find_if(merged_ptr->bindings.begin(), merged_ptr->bindings.end(),
+                                  [&binding](const ReflectedBinding &other) {
+                                      return other.set == binding.set && other.binding == binding.binding;
+                                  });
+
+        if(found == merged_ptr->bindings.end()) {
+            merged_ptr->bindings.push_back(binding);
+            continue;
+        }
+
+        if(found->type != binding.type || found->count != binding.count || found->unsized != binding.unsized) {
+            spdlog::error("[ShaderReflection] set {} binding {} is declared differently across stages",
+                          binding.set, binding.binding);
+            return false;
+        }
+
+        found->stages |= binding.stages;
+    }
+
+    std::sort(merged_ptr->bindings.begin(), merged_ptr->bindings.end(),
+              [](const ReflectedBinding &a, const ReflectedBinding &b) {
+                  return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+              });
+
+    // a single range visible to every stage that pushes anything, the simplest layout that stays compatible
+    if(stage.push_constants.size != 0) {
+        VkPushConstantRange &merged = merged_ptr->push_constants;
+
+        if(merged.size == 0) {
+            merged = stage.push_constants;
+        }
+        else {
+            uint32_t end = std::max(merged.offset + merged.size, stage.push_constants.offset + stage.push_constants.size);
+
+            merged.offset      = std::min(merged.offset, stage.push_constants.offset);
+            merged.size        = end - merged.offset;
+            merged.stageFlags |= stage.push_constants.stageFlags;
+        }
+    }
+
+    if(stage.inputs.empty() == false)
+        merged_ptr->inputs = stage.inputs;
+
+    merged_ptr->stages |= stage.stages;
+
+    return true;
+}
+
+} // namespace fl
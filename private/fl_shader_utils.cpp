@@ -2,8 +2,20 @@
 
 #include <fstream>
 
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 namespace fl {
 
+#define SPIRV_MAGIC 0x07230203u
+
 bool read_compiled_shader(const std::string &path, std::vector<char> *res_ptr) {
     std::ifstream file{
         path,
@@ -27,4 +39,90 @@ bool read_compiled_shader(const std::string &path, std::vector<char> *res_ptr) {
     return true;
 }
 
+bool map_compiled_shader(const std::string &path, MappedShader *res_ptr) {
+    void  *data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size{};
+    GetFileSizeEx(file, &file_size);
+    size = static_cast<size_t>(file_size.QuadPart);
+
+    // the mapping object keeps the file alive, so the file handle can be closed right away
+    HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+
+    if(mapping == nullptr)
+        return false;
+
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if(data == nullptr)
+        return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat file_stat{};
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    size = static_cast<size_t>(file_stat.st_size);
+
+    // the mapping stays valid after closing the descriptor
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED)
+        return false;
+#endif
+
+    res_ptr->words = static_cast<const uint32_t*>(data);
+    res_ptr->size = size;
+    res_ptr->map_handle = data;
+
+    // mappings start on a page boundary, so only the size and magic need checking
+    if(size % sizeof(uint32_t) != 0 || size < sizeof(uint32_t) || res_ptr->words[0] != SPIRV_MAGIC) {
+        unmap_compiled_shader(res_ptr);
+        return false;
+    }
+
+    return true;
+}
+
+void unmap_compiled_shader(MappedShader *shader_ptr) {
+    if(shader_ptr->map_handle == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(shader_ptr->map_handle);
+#else
+    munmap(shader_ptr->map_handle, shader_ptr->size);
+#endif
+
+    *shader_ptr = MappedShader{};
+}
+
+uint64_t hash_shader_code(const uint32_t *words, size_t size) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t*>(words);
+
+    uint64_t hash = 14695981039346656037ull;
+
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
 } // namespace fl
@@ -0,0 +1,170 @@
+#include <fl_sprite_batcher.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+
+namespace fl {
+
+SpriteBatcher::SpriteBatcher() {
+}
+
+SpriteBatcher::~SpriteBatcher() {
+    destroy();
+}
+
+bool SpriteBatcher::init(VkDevice logical, GpuAllocator *allocator_ptr, uint32_t frame_count,
+                         const BindlessHeap *heap_ptr, uint32_t max_sprites_per_frame) {
+    _logical_device = logical;
+    _allocator_ptr  = allocator_ptr;
+    _heap_ptr       = heap_ptr;
+    _max_sprites_per_frame = max_sprites_per_frame;
+
+    VkBufferCreateInfo buf_info{};
+    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buf_info.size = static_cast<VkDeviceSize>(frame_count) * max_sprites_per_frame * sizeof(SpriteInstance);
+    buf_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(logical, &buf_info, nullptr, &_instance_buf) != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements mem_reqs{};
+    vkGetBufferMemoryRequirements(logical, _instance_buf, &mem_reqs);
+
+    // device local and host visible memory lets the gpu read instances without crossing the bus,
+    // the cpu only ever writes sequentially so write combining keeps that fast
+    VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t mem_type = 0;
+
+    if(allocator_ptr->find_mem_type(mem_reqs.memoryTypeBits, props, &mem_type) == false)
+        props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    if(allocator_ptr->alloc_buffer(_instance_buf, props, &_instance_alloc) == false) {
+        spdlog::error("[SpriteBatcher] failed to allocate the instance buffer");
+        return false;
+    }
+
+    spdlog::info("[SpriteBatcher] {} sprites per frame, {} bytes of {} instance memory",
+                 max_sprites_per_frame, buf_info.size,
+                 props & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ? "device local" : "host");
+
+    begin_frame(0);
+
+    return true;
+}
+
+void SpriteBatcher::destroy() {
+    if(_instance_buf == VK_NULL_HANDLE)
+        return;
+
+    vkDestroyBuffer(_logical_device, _instance_buf, nullptr);
+    _allocator_ptr->free(&_instance_alloc);
+
+    _instance_buf = VK_NULL_HANDLE;
+    _frame_sprites = nullptr;
+}
+
+VertexInputDesc SpriteBatcher::get_input_desc() {
+    using SpriteLayout = VertexLayout<SpriteInstance,
+        FL_VERTEX_ATTR(SpriteInstance, center),
+        FL_VERTEX_ATTR(SpriteInstance, half_size),
+        FL_VERTEX_ATTR(SpriteInstance, uv_rect),
+        FL_VERTEX_ATTR_AS(SpriteInstance, color, VK_FORMAT_R8G8B8A8_UNORM),
+        FL_VERTEX_ATTR(SpriteInstance, rotation),
+        FL_VERTEX_ATTR(SpriteInstance, texture_idx)>;
+
+    // the corners come from gl_VertexIndex, only the instances are fetched
+    return SpriteLayout::get_input_desc(0, VK_VERTEX_INPUT_RATE_INSTANCE);
+}
+
+void SpriteBatcher::begin_frame(size_t frame_idx) {
+    _frame_offset  = static_cast<VkDeviceSize>(frame_idx) * _max_sprites_per_frame * sizeof(SpriteInstance);
+    _frame_sprites = reinterpret_cast<SpriteInstance*>(static_cast<uint8_t*>(_instance_alloc.mapped_ptr) + _frame_offset);
+
+    _batches.clear();
+    _sprite_count = 0;
+    _batch_count  = 0;
+}
+
+bool SpriteBatcher::draw(const SpriteMaterial &material, const SpriteInstance &sprite) {
+    SpriteInstance *dst = reserve(material, 1);
+
+    if(dst == nullptr)
+        return false;
+
+    *dst = sprite;
+
+    return true;
+}
+
+bool SpriteBatcher::draw(const SpriteMaterial &material, const SpriteInstance *sprites, uint32_t count) {
+    SpriteInstance *dst = reserve(material, count);
+
+    if(dst == nullptr)
+        return false;
+
+    memcpy(dst, sprites, count * sizeof(SpriteInstance));
+
+    return true;
+}
+
+SpriteInstance* SpriteBatcher::reserve(const SpriteMaterial &material, uint32_t count) {
+    if(_sprite_count + count > _max_sprites_per_frame) {
+        spdlog::error("[SpriteBatcher] more than {} sprites in a frame", _max_sprites_per_frame);
+        return nullptr;
+    }
+
+    if(_batches.empty() || (_batches.back().material == material) == false)
+        _batches.push_back(Batch{ material, _sprite_count, 0 });
+
+    _batches.back().instance_count += count;
+
+    SpriteInstance *dst = _frame_sprites + _sprite_count;
+    _sprite_count += count;
+
+    return dst;
+}
+
+void SpriteBatcher::flush(VkCommandBuffer cmd_buf) {
+    if(_batches.empty())
+        return;
+
+    // a single binding for the whole frame region, batches only differ in their first instance
+    vkCmdBindVertexBuffers(cmd_buf, 0, 1, &_instance_buf, &_frame_offset);
+
+    // every sprite layout reserves the heap's set, so it stays bound across the pipeline switches below
+    if(_heap_ptr != nullptr)
+        _heap_ptr->bind(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, _batches.front().material.layout);
+
+    VkPipeline bound_pipeline = VK_NULL_HANDLE;
+
+    for(const Batch &batch : _batches) {
+        const SpriteMaterial &material = batch.material;
+
+        if(material.pipeline != bound_pipeline) {
+            vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, material.pipeline);
+            bound_pipeline = material.pipeline;
+        }
+
+        vkCmdDraw(cmd_buf, 6, batch.instance_count, 0, batch.first_instance);
+    }
+
+    _batch_count += static_cast<uint32_t>(_batches.size());
+    _batches.clear();
+}
+
+bool SpriteBatcher::has_pending() const {
+    return _batches.empty() == false;
+}
+
+uint32_t SpriteBatcher::get_sprite_count() const {
+    return _sprite_count;
+}
+
+uint32_t SpriteBatcher::get_batch_count() const {
+    return _batch_count;
+}
+
+} // namespace fl
@@ -10,9 +10,13 @@ VkSwapchainKHR& Swapchain::get_raw_handle_ref() {
 bool Swapchain::init(VkDevice device, VkSwapchainCreateInfoKHR *create_info_ptr,
                      const VkAllocationCallbacks *alloc_callback) {
 
-    if(vkCreateSwapchainKHR(device, create_info_ptr, alloc_callback, &_handle) != VK_SUCCESS)
+    // the handle is only replaced on success, so a failed recreation leaves the old swap chain owned here
+    VkSwapchainKHR handle = VK_NULL_HANDLE;
+
+    if(vkCreateSwapchainKHR(device, create_info_ptr, alloc_callback, &handle) != VK_SUCCESS)
         return false;
     // else
+    _handle          = handle;
     _logical_device  = device;
     _img_fmt         = create_info_ptr->imageFormat;
     _img_extent      = create_info_ptr->imageExtent;
@@ -0,0 +1,76 @@
+#include <fl_texture.hpp>
+
+#include <spdlog/spdlog.h>
+
+namespace fl {
+
+// every format textures are created with has 4 bytes per texel
+const VkDeviceSize TEXEL_SIZE = 4;
+
+Texture::Texture() {
+}
+
+Texture::~Texture() {
+    destroy();
+}
+
+bool Texture::init(VkDevice logical, GpuAllocator *allocator_ptr, UploadService *upload_ptr,
+                   VkExtent2D extent, const void *pixels, VkFormat format) {
+    _logical_device = logical;
+    _allocator_ptr  = allocator_ptr;
+    _extent         = extent;
+
+    if(upload_ptr->create_device_local_image(extent, format, VK_IMAGE_USAGE_SAMPLED_BIT, &_img, &_alloc) == false) {
+        spdlog::error("[Texture] failed to create a {}x{} image", extent.width, extent.height);
+        return false;
+    }
+
+    VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * TEXEL_SIZE;
+
+    if(upload_ptr->upload_image(_img, extent, pixels, size) == false)
+        return false;
+
+    VkImageViewCreateInfo view_info{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = _img;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+
+    if(vkCreateImageView(_logical_device, &view_info, nullptr, &_view) != VK_SUCCESS) {
+        spdlog::error("[Texture] failed to create image view");
+        return false;
+    }
+
+    return true;
+}
+
+void Texture::destroy() {
+    if(_allocator_ptr == nullptr)
+        return;
+
+    vkDestroyImageView(_logical_device, _view, nullptr);
+    vkDestroyImage(_logical_device, _img, nullptr);
+
+    _allocator_ptr->free(&_alloc);
+
+    _view = VK_NULL_HANDLE;
+    _img  = VK_NULL_HANDLE;
+    _allocator_ptr = nullptr;
+}
+
+VkImage Texture::get_raw_handle() const {
+    return _img;
+}
+
+VkImageView Texture::get_raw_view_handle() const {
+    return _view;
+}
+
+VkExtent2D Texture::get_extent() const {
+    return _extent;
+}
+
+} // namespace fl
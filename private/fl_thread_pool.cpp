@@ -0,0 +1,69 @@
+#include <fl_thread_pool.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace fl {
+
+ThreadPool::ThreadPool() {
+}
+
+ThreadPool::~ThreadPool() {
+    destroy();
+}
+
+bool ThreadPool::init(uint32_t thread_count) {
+    if(thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    _stopping = false;
+    _workers.reserve(thread_count);
+
+    for(uint32_t i = 0; i < thread_count; i++)
+        _workers.emplace_back(&ThreadPool::worker_loop, this);
+
+    spdlog::info("[ThreadPool] started {} worker threads", thread_count);
+
+    return true;
+}
+
+void ThreadPool::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+
+    _job_cv.notify_all();
+
+    for(std::thread &worker : _workers)
+        worker.join();
+
+    _workers.clear();
+}
+
+uint32_t ThreadPool::get_thread_count() const {
+    return static_cast<uint32_t>(_workers.size());
+}
+
+void ThreadPool::worker_loop() {
+    while(true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_cv.wait(lock, [this]() { return _stopping || _jobs.empty() == false; });
+
+            // remaining jobs still run when stopping, somebody may be waiting on their futures
+            if(_jobs.empty())
+                return;
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+} // namespace fl
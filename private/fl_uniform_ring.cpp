@@ -0,0 +1,209 @@
+#include <fl_uniform_ring.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace fl {
+
+UniformRing::UniformRing() {
+}
+
+UniformRing::~UniformRing() {
+    destroy();
+}
+
+bool UniformRing::init(VkPhysicalDevice physical, VkDevice logical, GpuAllocator *allocator_ptr, uint32_t frame_count,
+                       VkDeviceSize frame_size, VkDeviceSize binding_range) {
+    _logical_device = logical;
+    _allocator_ptr  = allocator_ptr;
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physical, &props);
+
+    // every allocation may be bound as either kind of buffer, so it has to satisfy both
+    _alignment = std::max(props.limits.minUniformBufferOffsetAlignment, props.limits.minStorageBufferOffsetAlignment);
+
+    _binding_range = std::min({ binding_range,
+                                static_cast<VkDeviceSize>(props.limits.maxUniformBufferRange),
+                                static_cast<VkDeviceSize>(props.limits.maxStorageBufferRange) });
+
+    // frames start aligned so offsets from any frame are
+    _frame_size = (frame_size + _alignment - 1) / _alignment * _alignment;
+
+    // a binding reads _binding_range bytes past its offset, the tail keeps the last frame's ones inside the buffer
+    VkDeviceSize buf_size = static_cast<VkDeviceSize>(frame_count) * _frame_size + _binding_range;
+
+    if(buf_size > std::numeric_limits<uint32_t>::max()) {
+        spdlog::error("[UniformRing] {} bytes do not fit 32 bit dynamic offsets", buf_size);
+        return false;
+    }
+
+    VkBufferCreateInfo buf_info{};
+    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buf_info.size = buf_size;
+    buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(logical, &buf_info, nullptr, &_buf) != VK_SUCCESS)
+        return false;
+
+    VkMemoryRequirements mem_reqs{};
+    vkGetBufferMemoryRequirements(logical, _buf, &mem_reqs);
+
+    // same reasoning as the sprite instances, the cpu only writes sequentially and the gpu reads every frame
+    VkMemoryPropertyFlags mem_props = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t mem_type = 0;
+
+    if(allocator_ptr->find_mem_type(mem_reqs.memoryTypeBits, mem_props, &mem_type) == false)
+        mem_props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    if(allocator_ptr->alloc_buffer(_buf, mem_props, &_alloc) == false) {
+        spdlog::error("[UniformRing] failed to allocate the ring buffer");
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[2]{};
+
+    bindings[0].binding         = UNIFORM_RING_UNIFORM_BINDING;
+    bindings[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags      = VK_SHADER_STAGE_ALL;
+
+    bindings[1].binding         = UNIFORM_RING_STORAGE_BINDING;
+    bindings[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags      = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorSetLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 2;
+    layout_info.pBindings = bindings;
+
+    if(vkCreateDescriptorSetLayout(_logical_device, &layout_info, nullptr, &_set_layout) != VK_SUCCESS) {
+        spdlog::error("[UniformRing] failed to create descriptor set layout");
+        return false;
+    }
+
+    VkDescriptorPoolSize pool_sizes[2]{};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    pool_sizes[0].descriptorCount = 1;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    pool_sizes[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+
+    if(vkCreateDescriptorPool(_logical_device, &pool_info, nullptr, &_pool) != VK_SUCCESS) {
+        spdlog::error("[UniformRing] failed to create descriptor pool");
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = _pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &_set_layout;
+
+    if(vkAllocateDescriptorSets(_logical_device, &alloc_info, &_set) != VK_SUCCESS) {
+        spdlog::error("[UniformRing] failed to allocate the descriptor set");
+        return false;
+    }
+
+    // both bindings start at 0, the dynamic offsets move them over the ring
+    VkDescriptorBufferInfo buf_infos[2]{};
+
+    for(VkDescriptorBufferInfo &info : buf_infos) {
+        info.buffer = _buf;
+        info.offset = 0;
+        info.range  = _binding_range;
+    }
+
+    VkWriteDescriptorSet writes[2]{};
+
+    for(uint32_t i = 0; i < 2; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = _set;
+        writes[i].dstBinding = bindings[i].binding;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = bindings[i].descriptorType;
+        writes[i].pBufferInfo = &buf_infos[i];
+    }
+
+    vkUpdateDescriptorSets(_logical_device, 2, writes, 0, nullptr);
+
+    spdlog::info("[UniformRing] {} bytes per frame, {} byte alignment, {} bytes of {} memory",
+                 _frame_size, _alignment, buf_size,
+                 mem_props & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ? "device local" : "host");
+
+    begin_frame(0);
+
+    return true;
+}
+
+void UniformRing::destroy() {
+    if(_buf == VK_NULL_HANDLE)
+        return;
+
+    // the set goes away with its pool
+    vkDestroyDescriptorPool(_logical_device, _pool, nullptr);
+    vkDestroyDescriptorSetLayout(_logical_device, _set_layout, nullptr);
+
+    vkDestroyBuffer(_logical_device, _buf, nullptr);
+    _allocator_ptr->free(&_alloc);
+
+    _pool = VK_NULL_HANDLE;
+    _set  = VK_NULL_HANDLE;
+    _set_layout = VK_NULL_HANDLE;
+    _buf  = VK_NULL_HANDLE;
+}
+
+void UniformRing::begin_frame(size_t frame_idx) {
+    _frame_base = static_cast<VkDeviceSize>(frame_idx) * _frame_size;
+    _frame_head.store(0, std::memory_order_relaxed);
+}
+
+bool UniformRing::allocate(VkDeviceSize size, UniformAllocation *alloc_ptr) {
+    if(size > _binding_range) {
+        spdlog::error("[UniformRing] {} bytes do not fit the {} byte binding range", size, _binding_range);
+        return false;
+    }
+
+    VkDeviceSize aligned = (size + _alignment - 1) / _alignment * _alignment;
+    VkDeviceSize offset  = _frame_head.fetch_add(aligned, std::memory_order_relaxed);
+
+    if(offset + aligned > _frame_size) {
+        spdlog::error("[UniformRing] more than {} bytes allocated in a frame", _frame_size);
+        return false;
+    }
+
+    offset += _frame_base;
+
+    alloc_ptr->ptr    = static_cast<uint8_t*>(_alloc.mapped_ptr) + offset;
+    alloc_ptr->offset = static_cast<uint32_t>(offset);
+
+    return true;
+}
+
+void UniformRing::bind(VkCommandBuffer cmd_buf, VkPipelineBindPoint bind_point, VkPipelineLayout layout,
+                       uint32_t uniform_offset, uint32_t storage_offset) const {
+    // ordered by binding number, like the spec wants
+    uint32_t offsets[2] = { uniform_offset, storage_offset };
+
+    vkCmdBindDescriptorSets(cmd_buf, bind_point, layout, UNIFORM_RING_SET, 1, &_set, 2, offsets);
+}
+
+VkDescriptorSetLayout UniformRing::get_raw_set_layout_handle() const {
+    return _set_layout;
+}
+
+VkDeviceSize UniformRing::get_frame_used() const {
+    return std::min(_frame_head.load(std::memory_order_relaxed), _frame_size);
+}
+
+} // namespace fl
@@ -0,0 +1,412 @@
+#include <fl_upload_service.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace fl {
+
+// keeps staged copies aligned for fast memcpy, vkCmdCopyBuffer itself has no alignment requirement
+#define STAGING_ALIGNMENT 16
+
+UploadService::UploadService() {
+}
+
+UploadService::~UploadService() {
+    destroy();
+}
+
+bool UploadService::init(VkDevice logical, GpuAllocator *allocator_ptr, uint32_t transfer_family_idx,
+                         VkQueue transfer_queue, uint32_t graphics_family_idx, VkDeviceSize ring_size) {
+    _logical_device      = logical;
+    _allocator_ptr       = allocator_ptr;
+    _transfer_family_idx = transfer_family_idx;
+    _graphics_family_idx = graphics_family_idx;
+
+    _sharing_families = { transfer_family_idx };
+    add_sharing_family(graphics_family_idx);
+    _transfer_queue      = transfer_queue;
+    _ring_size           = ring_size;
+
+    VkBufferCreateInfo ring_info{};
+    ring_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    ring_info.size = ring_size;
+    ring_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    ring_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // only ever read by the transfer queue
+
+    if(vkCreateBuffer(logical, &ring_info, nullptr, &_ring_buf) != VK_SUCCESS)
+        return false;
+
+    if(allocator_ptr->alloc_buffer(_ring_buf,
+                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                   &_ring_alloc) == false) {
+        spdlog::error("[UploadService] failed to allocate a staging ring of {} bytes", ring_size);
+        return false;
+    }
+
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = transfer_family_idx;
+
+    if(vkCreateCommandPool(logical, &pool_info, nullptr, &_cmd_pool) != VK_SUCCESS)
+        return false;
+
+    _submissions.resize(UPLOAD_SUBMISSION_SLOTS);
+
+    std::vector<VkCommandBuffer> cmd_bufs(UPLOAD_SUBMISSION_SLOTS);
+
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = _cmd_pool;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = UPLOAD_SUBMISSION_SLOTS;
+
+    if(vkAllocateCommandBuffers(logical, &alloc_info, cmd_bufs.data()) != VK_SUCCESS)
+        return false;
+
+    VkSemaphoreCreateInfo sem_info{};
+    sem_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    for(uint32_t i = 0; i < UPLOAD_SUBMISSION_SLOTS; i++) {
+        Submission &submission = _submissions[i];
+        submission.cmd_buf = cmd_bufs[i];
+
+        if(vkCreateSemaphore(logical, &sem_info, nullptr, &submission.sema) != VK_SUCCESS)
+            return false;
+
+        if(vkCreateFence(logical, &fence_info, nullptr, &submission.fence) != VK_SUCCESS)
+            return false;
+    }
+
+    spdlog::info("[UploadService] staging ring of {} bytes, uploading on queue family {}",
+                 ring_size, transfer_family_idx);
+
+    return true;
+}
+
+void UploadService::destroy() {
+    if(_logical_device == VK_NULL_HANDLE)
+        return;
+
+    wait_idle();
+
+    for(Submission &submission : _submissions) {
+        vkDestroySemaphore(_logical_device, submission.sema, nullptr);
+        vkDestroyFence(_logical_device, submission.fence, nullptr);
+    }
+
+    _submissions.clear();
+
+    vkDestroyCommandPool(_logical_device, _cmd_pool, nullptr);
+
+    vkDestroyBuffer(_logical_device, _ring_buf, nullptr);
+    _allocator_ptr->free(&_ring_alloc);
+
+    _cmd_pool = VK_NULL_HANDLE;
+    _ring_buf = VK_NULL_HANDLE;
+    _logical_device = VK_NULL_HANDLE;
+}
+
+void UploadService::add_sharing_family(uint32_t family_idx) {
+    if(std::find(_sharing_families.begin(), _sharing_families.end(), family_idx) == _sharing_families.end())
+        _sharing_families.push_back(family_idx);
+}
+
+bool UploadService::create_device_local_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                                               VkBuffer *buffer_ptr, GpuAllocation *alloc_ptr) {
+    VkBufferCreateInfo buf_info{};
+    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buf_info.size = size;
+    buf_info.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    // concurrent sharing avoids queue family ownership transfers, buffers lose nothing by it
+    if(_sharing_families.size() > 1) {
+        buf_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buf_info.queueFamilyIndexCount = static_cast<uint32_t>(_sharing_families.size());
+        buf_info.pQueueFamilyIndices = _sharing_families.data();
+    }
+    else
+        buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(_logical_device, &buf_info, nullptr, buffer_ptr) != VK_SUCCESS)
+        return false;
+
+    return _allocator_ptr->alloc_buffer(*buffer_ptr, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, alloc_ptr);
+}
+
+bool UploadService::create_device_local_image(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+                                              VkImage *image_ptr, GpuAllocation *alloc_ptr) {
+    VkImageCreateInfo img_info{};
+    img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    img_info.imageType = VK_IMAGE_TYPE_2D;
+    img_info.format = format;
+    img_info.extent = { extent.width, extent.height, 1 };
+    img_info.mipLevels = 1;
+    img_info.arrayLayers = 1;
+    img_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    img_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    img_info.usage = usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    img_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    // read only images are written once, concurrent sharing costs them nothing either
+    if(_sharing_families.size() > 1) {
+        img_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        img_info.queueFamilyIndexCount = static_cast<uint32_t>(_sharing_families.size());
+        img_info.pQueueFamilyIndices = _sharing_families.data();
+    }
+    else
+        img_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateImage(_logical_device, &img_info, nullptr, image_ptr) != VK_SUCCESS)
+        return false;
+
+    return _allocator_ptr->alloc_image(*image_ptr, img_info.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, alloc_ptr);
+}
+
+bool UploadService::upload(VkBuffer dst, VkDeviceSize dst_offset, const void *data, VkDeviceSize size) {
+    const uint8_t *src_bytes = static_cast<const uint8_t*>(data);
+
+    // anything bigger than the ring goes through in ring sized pieces
+    while(size > 0) {
+        VkDeviceSize chunk_size = std::min(size, _ring_size);
+        VkDeviceSize ring_offset = 0;
+
+        if(reserve_ring(chunk_size, &ring_offset) == false)
+            return false;
+
+        memcpy(static_cast<uint8_t*>(_ring_alloc.mapped_ptr) + ring_offset, src_bytes, chunk_size);
+
+        VkBufferCopy region{};
+        region.srcOffset = ring_offset;
+        region.dstOffset = dst_offset;
+        region.size = chunk_size;
+
+        vkCmdCopyBuffer(_submissions[_recording_idx].cmd_buf, _ring_buf, dst, 1, &region);
+
+        src_bytes  += chunk_size;
+        dst_offset += chunk_size;
+        size       -= chunk_size;
+    }
+
+    return true;
+}
+
+bool UploadService::upload_image(VkImage dst, VkExtent2D extent, const void *data, VkDeviceSize size) {
+    if(size > _ring_size) {
+        spdlog::error("[UploadService] image of {} bytes does not fit into the staging ring", size);
+        return false;
+    }
+
+    VkDeviceSize ring_offset = 0;
+
+    if(reserve_ring(size, &ring_offset) == false)
+        return false;
+
+    memcpy(static_cast<uint8_t*>(_ring_alloc.mapped_ptr) + ring_offset, data, size);
+
+    VkCommandBuffer cmd_buf = _submissions[_recording_idx].cmd_buf;
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dst;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+
+    // the old contents are discarded, nothing has been written to a new image yet
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = ring_offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { extent.width, extent.height, 1 };
+
+    vkCmdCopyBufferToImage(cmd_buf, _ring_buf, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // transfer queues know no shader stages, the graphics submit waiting on the flush semaphore orders the reads
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    return true;
+}
+
+VkSemaphore UploadService::flush() {
+    if(_recording == false)
+        return VK_NULL_HANDLE;
+
+    VkSemaphore sema = _submissions[_recording_idx].sema;
+
+    if(submit_recording(true) == false)
+        return VK_NULL_HANDLE;
+
+    return sema;
+}
+
+void UploadService::wait_idle() {
+    if(_recording)
+        submit_recording(false);
+
+    for(Submission &submission : _submissions) {
+        if(submission.in_flight == false)
+            continue;
+
+        vkWaitForFences(_logical_device, 1, &submission.fence, VK_TRUE, UINT64_MAX);
+        retire(&submission);
+    }
+}
+
+bool UploadService::begin_recording() {
+    Submission &submission = _submissions[_recording_idx];
+
+    // every slot is in flight, the one about to be reused is the oldest
+    if(submission.in_flight) {
+        vkWaitForFences(_logical_device, 1, &submission.fence, VK_TRUE, UINT64_MAX);
+        retire(&submission);
+    }
+
+    vkResetCommandBuffer(submission.cmd_buf, 0);
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if(vkBeginCommandBuffer(submission.cmd_buf, &begin_info) != VK_SUCCESS)
+        return false;
+
+    _recording = true;
+
+    return true;
+}
+
+bool UploadService::submit_recording(bool signal_sema) {
+    Submission &submission = _submissions[_recording_idx];
+
+    _recording = false;
+
+    if(vkEndCommandBuffer(submission.cmd_buf) != VK_SUCCESS)
+        return false;
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &submission.cmd_buf;
+
+    if(signal_sema) {
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &submission.sema;
+    }
+
+    vkResetFences(_logical_device, 1, &submission.fence);
+
+    if(vkQueueSubmit(_transfer_queue, 1, &submit_info, submission.fence) != VK_SUCCESS) {
+        spdlog::error("[UploadService] failed to submit uploads");
+        return false;
+    }
+
+    submission.in_flight = true;
+    _recording_idx = (_recording_idx + 1) % _submissions.size();
+
+    return true;
+}
+
+bool UploadService::reserve_ring(VkDeviceSize size, VkDeviceSize *offset_ptr) {
+    size = (size + STAGING_ALIGNMENT - 1) & ~static_cast<VkDeviceSize>(STAGING_ALIGNMENT - 1);
+
+    while(true) {
+        // recording first, the reserved bytes are charged to the submission being recorded
+        if(_recording == false && begin_recording() == false)
+            return false;
+
+        retire_completed();
+
+        // nothing is staged, so start over from the front instead of wrapping later
+        if(_ring_used == 0)
+            _ring_head = 0;
+
+        VkDeviceSize offset = _ring_head;
+        VkDeviceSize waste  = 0;
+
+        if(offset + size > _ring_size) {
+            waste  = _ring_size - offset;
+            offset = 0;
+        }
+
+        if(_ring_used + waste + size <= _ring_size) {
+            // the wrap around waste is released together with the submission that first uses the front again
+            _submissions[_recording_idx].ring_bytes += waste + size;
+
+            _ring_used += waste + size;
+            _ring_head  = offset + size;
+
+            *offset_ptr = offset;
+            return true;
+        }
+
+        // the ring is full, block on the oldest submission in flight
+        bool waited = false;
+
+        for(size_t i = 0; i < _submissions.size() && waited == false; i++) {
+            Submission &submission = _submissions[(_recording_idx + i) % _submissions.size()];
+
+            if(submission.in_flight == false)
+                continue;
+
+            vkWaitForFences(_logical_device, 1, &submission.fence, VK_TRUE, UINT64_MAX);
+            waited = true;
+        }
+
+        if(waited)
+            continue;
+
+        // the copies being recorded hold the whole ring, submit them and wait on the next pass. Nothing waits
+        // on the semaphore of this submission, so it is left unsignaled
+        if(submit_recording(false) == false) {
+            spdlog::error("[UploadService] cannot reserve {} bytes of staging memory", size);
+            return false;
+        }
+    }
+}
+
+void UploadService::retire_completed() {
+    // slots are reused round robin, so starting at the recording slot visits them oldest first.
+    // submissions complete in order, stop at the first one still running
+    for(size_t i = 0; i < _submissions.size(); i++) {
+        Submission &submission = _submissions[(_recording_idx + i) % _submissions.size()];
+
+        if(submission.in_flight == false)
+            continue;
+
+        if(vkGetFenceStatus(_logical_device, submission.fence) != VK_SUCCESS)
+            break;
+
+        retire(&submission);
+    }
+}
+
+void UploadService::retire(Submission *submission_ptr) {
+    _ring_used -= submission_ptr->ring_bytes;
+
+    submission_ptr->ring_bytes = 0;
+    submission_ptr->in_flight = false;
+}
+
+} // namespace fl
@@ -0,0 +1,157 @@
+#include <fl_vertex_layout.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace fl {
+
+uint16_t pack_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign     = (bits >> 16) & 0x8000u;
+    int32_t  exponent = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    // infinity or NaN, a NaN keeps a mantissa bit so it does not collapse into infinity
+    if(((bits >> 23) & 0xffu) == 0xffu)
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+
+    // too large, clamps to infinity
+    if(exponent >= 0x1f)
+        return static_cast<uint16_t>(sign | 0x7c00u);
+
+    // too small even for a subnormal half
+    if(exponent < -10)
+        return static_cast<uint16_t>(sign);
+
+    if(exponent <= 0) {
+        // subnormal half, the implicit leading bit becomes explicit
+        mantissa |= 0x800000u;
+
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+
+        uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        uint32_t halfway   = 1u << (shift - 1u);
+
+        if(remainder > halfway || (remainder == halfway && (half_mantissa & 1u)))
+            half_mantissa++;
+
+        return static_cast<uint16_t>(sign | half_mantissa);
+    }
+
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+
+    // round to nearest even, a carry into the exponent is still the right result
+    uint32_t remainder = mantissa & 0x1fffu;
+    if(remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+        half++;
+
+    return static_cast<uint16_t>(half);
+}
+
+float unpack_half(uint16_t half) {
+    uint32_t sign     = static_cast<uint32_t>(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1fu;
+    uint32_t mantissa = half & 0x3ffu;
+
+    uint32_t bits;
+
+    if(exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else if(exponent == 0) {
+        if(mantissa == 0) {
+            bits = sign;
+        }
+        else {
+            // subnormal, normalize it for the wider exponent range of a float
+            int32_t float_exponent = 127 - 15 + 1;
+
+            while((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                float_exponent--;
+            }
+
+            bits = sign | (static_cast<uint32_t>(float_exponent) << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    }
+    else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static uint32_t pack_unorm8(float value) {
+    return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+static int16_t pack_snorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static float unpack_snorm16(int16_t value) {
+    // both -32768 and -32767 map to -1
+    return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+Half2::Half2(float x, float y)
+    : x(pack_half(x)), y(pack_half(y)) {
+}
+
+Half2::Half2(const glm::vec2 &v)
+    : Half2(v.x, v.y) {
+}
+
+glm::vec2 Half2::unpack() const {
+    return glm::vec2(unpack_half(x), unpack_half(y));
+}
+
+Half4::Half4(float x, float y, float z, float w)
+    : x(pack_half(x)), y(pack_half(y)), z(pack_half(z)), w(pack_half(w)) {
+}
+
+Half4::Half4(const glm::vec4 &v)
+    : Half4(v.x, v.y, v.z, v.w) {
+}
+
+glm::vec4 Half4::unpack() const {
+    return glm::vec4(unpack_half(x), unpack_half(y), unpack_half(z), unpack_half(w));
+}
+
+Unorm8x4::Unorm8x4(float r, float g, float b, float a)
+    : packed(pack_unorm8(r) | pack_unorm8(g) << 8 | pack_unorm8(b) << 16 | pack_unorm8(a) << 24) {
+}
+
+Unorm8x4::Unorm8x4(const glm::vec4 &v)
+    : Unorm8x4(v.x, v.y, v.z, v.w) {
+}
+
+glm::vec4 Unorm8x4::unpack() const {
+    return glm::vec4(
+        static_cast<float>(packed & 0xffu)         / 255.0f,
+        static_cast<float>((packed >> 8) & 0xffu)  / 255.0f,
+        static_cast<float>((packed >> 16) & 0xffu) / 255.0f,
+        static_cast<float>((packed >> 24) & 0xffu) / 255.0f
+    );
+}
+
+Snorm16x2::Snorm16x2(float x, float y)
+    : x(pack_snorm16(x)), y(pack_snorm16(y)) {
+}
+
+Snorm16x2::Snorm16x2(const glm::vec2 &v)
+    : Snorm16x2(v.x, v.y) {
+}
+
+glm::vec2 Snorm16x2::unpack() const {
+    return glm::vec2(unpack_snorm16(x), unpack_snorm16(y));
+}
+
+} // namespace fl
@@ -29,9 +29,15 @@ VkCore::~VkCore() {
             spdlog::error("Cannot load debug messenger destroy function");
     }
 
-    // TODO: HACK: the swap chain should handle this itself
-    destroy_swap_chain();
-    _instance.destroy_surface(_surface, nullptr);
+    // headless cores never loaded the surface and swap chain extensions
+    if(_headless == false) {
+        // TODO: HACK: the swap chain should handle this itself
+        destroy_swap_chain();
+        _instance.destroy_surface(_surface, nullptr);
+    }
+
+    _offscreen_target.destroy();
+    _allocator.destroy();
     vkDestroyDevice(_logical_device, nullptr);
 
     if(_device_manager_ptr)
@@ -50,6 +56,9 @@ bool action_check(bool result, const char *p_msg) {
 }
 
 bool VkCore::init(std::string app_name, GLFWwindow *window_ptr) {
+    _headless = false;
+    _device_req_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
     action_check(setup_instance(app_name), "setup instance");
 
     if(_enable_debug)
@@ -58,6 +67,38 @@ bool VkCore::init(std::string app_name, GLFWwindow *window_ptr) {
     if(!action_check(setup_glfw_surface(window_ptr), "setup glfw surface"))
         return false;
 
+    if(setup_device() == false)
+        return false;
+
+    if(!action_check(create_swap_chain(window_ptr), "create swap chain"))
+        return false;
+
+    return true;
+}
+
+bool VkCore::init_headless(std::string app_name, VkExtent2D extent, uint32_t img_count) {
+    _headless = true;
+
+    if(!action_check(setup_instance(app_name), "setup headless instance"))
+        return false;
+
+    if(_enable_debug)
+        setup_debug_messenger();
+
+    if(setup_device() == false)
+        return false;
+
+    _chosen_img_format = VK_FORMAT_R8G8B8A8_SRGB;
+    _chosen_extent = extent;
+
+    return action_check(
+        _offscreen_target.init(_logical_device, &_allocator,
+                               _chosen_img_format, _chosen_extent, img_count),
+        "create offscreen target"
+    );
+}
+
+bool VkCore::setup_device() {
     VkPhysicalDevice physical_device = pick_physical_device();
 
     if(physical_device == VK_NULL_HANDLE) {
@@ -81,25 +122,57 @@ bool VkCore::init(std::string app_name, GLFWwindow *window_ptr) {
 
     _logical_device = logical_device;
 
+    if(!action_check(_allocator.init(physical_device, logical_device), "setup gpu allocator"))
+        return false;
+
     _device_manager_ptr->get_queue(_queue_family_idxs.graphics.value(), &_graphics_queue);
     if(_graphics_queue == VK_NULL_HANDLE)
         spdlog::error("graphics queue is null");
     else
         spdlog::info("grabbed graphics queue");
 
+    _transfer_queue = _graphics_queue;
+
+    if(_queue_family_idxs.transfer.has_value()) {
+        _device_manager_ptr->get_queue(_queue_family_idxs.transfer.value(), &_transfer_queue);
+        spdlog::info("grabbed dedicated transfer queue from family {}", _queue_family_idxs.transfer.value());
+    }
+
+    _compute_queue = _graphics_queue;
+
+    if(_queue_family_idxs.compute.has_value()) {
+        _device_manager_ptr->get_queue(_queue_family_idxs.compute.value(), &_compute_queue);
+        spdlog::info("grabbed async compute queue from family {}", _queue_family_idxs.compute.value());
+    }
+
+    // headless devices have nothing to present to
+    if(_queue_family_idxs.present.has_value() == false)
+        return true;
+
     _device_manager_ptr->get_queue(_queue_family_idxs.present.value(), &_present_queue);
-    if(_graphics_queue == VK_NULL_HANDLE)
+    if(_present_queue == VK_NULL_HANDLE)
         spdlog::error("present queue is null");
     else
         spdlog::info("grabbed present queue");
 
+    return true;
+}
 
-    if(!action_check(create_swap_chain(window_ptr), "create swap chain"))
-        return false;
+bool VkCore::is_headless() const {
+    return _headless;
+}
 
-    return true;
+void VkCore::set_swap_chain_img_count(uint32_t count) {
+    _desired_img_count = count;
 }
 
+void VkCore::set_present_policy(PresentPolicy policy) {
+    _present_policy = policy;
+}
+
+VkPresentModeKHR VkCore::get_present_mode() const {
+    return _present_mode;
+}
 
 VkDeviceManager* VkCore::get_device_manager_ptr() {
     return _device_manager_ptr;
@@ -109,6 +182,14 @@ Swapchain* VkCore::get_swap_chain_ptr() {
     return &_swap_chain;
 }
 
+OffscreenTarget* VkCore::get_offscreen_target_ptr() {
+    return &_offscreen_target;
+}
+
+GpuAllocator* VkCore::get_allocator_ptr() {
+    return &_allocator;
+}
+
 
 VkExtent2D VkCore::get_swap_chain_extent() const {
     return _chosen_extent;
@@ -117,6 +198,10 @@ const QueueFamilyIdxs* VkCore::get_queue_family_idxs_ptr() const {
     return &_queue_family_idxs;
 }
 
+const DeviceFeatures* VkCore::get_device_features_ptr() const {
+    return &_device_features;
+}
+
 void log_glfw_required_extensions_support() {
     std::vector<VkExtensionProperties> properties;
     uint32_t property_count = get_vk_instance_extension_properties(&properties);
@@ -147,11 +232,16 @@ void log_glfw_required_extensions_support() {
     }
 }
 
-std::vector<const char*> get_req_instance_extensions(bool enable_validation_layers) {
-    uint32_t glfw_extensions_count = 0;
-    const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extensions_count);
+std::vector<const char*> get_req_instance_extensions(bool enable_validation_layers, bool headless) {
+    std::vector<const char*> app_extensions{};
+
+    // glfw is never initialized when running headless, so it has no surface extensions to ask for
+    if(headless == false) {
+        uint32_t glfw_extensions_count = 0;
+        const char **glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extensions_count);
 
-    std::vector<const char*> app_extensions{glfw_extensions, glfw_extensions + glfw_extensions_count};
+        app_extensions.assign(glfw_extensions, glfw_extensions + glfw_extensions_count);
+    }
 
     if(enable_validation_layers) {
         app_extensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -171,7 +261,21 @@ bool VkCore::setup_instance(std::string app_name) {
     app_info.applicationVersion = VK_MAKE_VERSION(0, 0, 1);
     app_info.pEngineName = "No Engine";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
+
+    // vkEnumerateInstanceVersion only exists from 1.1 loaders on, a missing one means 1.0
+    auto enumerate_version_func = (PFN_vkEnumerateInstanceVersion)
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+
+    uint32_t loader_api_version = VK_API_VERSION_1_0;
+
+    if(enumerate_version_func != nullptr)
+        enumerate_version_func(&loader_api_version);
+
+    _instance_api_version = std::min(loader_api_version, MAX_API_VERSION);
+    app_info.apiVersion = _instance_api_version;
+
+    spdlog::info("requesting vulkan {}.{}", VK_API_VERSION_MAJOR(_instance_api_version),
+                 VK_API_VERSION_MINOR(_instance_api_version));
 
 
     // CREATE INSTANCE INFO
@@ -181,9 +285,10 @@ bool VkCore::setup_instance(std::string app_name) {
 
 
     // GLFW REQUIRED VULKAN EXTENSIONS SUPPORT
-    log_glfw_required_extensions_support();
+    if(_headless == false)
+        log_glfw_required_extensions_support();
 
-    std::vector<const char*> required_extensions = get_req_instance_extensions(_enable_debug);
+    std::vector<const char*> required_extensions = get_req_instance_extensions(_enable_debug, _headless);
 
     create_info.enabledExtensionCount = required_extensions.size();
     create_info.ppEnabledExtensionNames = required_extensions.data();
@@ -295,10 +400,14 @@ bool VkCore::is_device_suitable(VkPhysicalDevice device) {
         return false;
     // else extensions supported
 
-    SwapChainSupportInfo support_info{};
-    get_physical_swap_chain_support(device, _surface, &support_info);
+    bool swap_chain_support = true;
 
-    bool swap_chain_support = !support_info.formats.empty() && !support_info.present_modes.empty();
+    if(_headless == false) {
+        SwapChainSupportInfo support_info{};
+        get_physical_swap_chain_support(device, _surface, &support_info);
+
+        swap_chain_support = !support_info.formats.empty() && !support_info.present_modes.empty();
+    }
 
     if(swap_chain_support && device_features.geometryShader)
         return true;
@@ -314,26 +423,46 @@ bool VkCore::find_queue_families(VkPhysicalDevice physical_device, QueueFamilyId
     for(size_t i = 0; i < queue_family_props.size(); i++) {
         const auto &family_prop = queue_family_props[i];
 
-        if(family_prop.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        if(family_prop.queueFlags & VK_QUEUE_GRAPHICS_BIT && idxs_ptr->graphics.has_value() == false)
             idxs_ptr->graphics = i;
 
-        if(is_physical_surface_supported(physical_device, i, _surface))
+        if(_headless == false && idxs_ptr->present.has_value() == false &&
+           is_physical_surface_supported(physical_device, i, _surface))
             idxs_ptr->present = i;
 
-        if(idxs_ptr->graphics.has_value() && idxs_ptr->present.has_value())
-            return true;
+        // keep searching past graphics and present, the transfer only family usually comes last
+        bool transfer_only = (family_prop.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                             !(family_prop.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+
+        if(transfer_only && idxs_ptr->transfer.has_value() == false)
+            idxs_ptr->transfer = i;
+
+        bool compute_only = (family_prop.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
+                            !(family_prop.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+
+        if(compute_only && idxs_ptr->compute.has_value() == false)
+            idxs_ptr->compute = i;
     }
     
-    return false;
+    return idxs_ptr->graphics.has_value() && (_headless || idxs_ptr->present.has_value());
 }
 
 bool VkCore::setup_logical_device(VkPhysicalDevice physical_device, VkDevice *logical_device_ptr) {
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos{};
 
     std::set<uint32_t> unique_queue_families_idxs {
-        _queue_family_idxs.graphics.value(), _queue_family_idxs.present.value()
+        _queue_family_idxs.graphics.value()
     };
 
+    if(_queue_family_idxs.present.has_value())
+        unique_queue_families_idxs.insert(_queue_family_idxs.present.value());
+
+    if(_queue_family_idxs.transfer.has_value())
+        unique_queue_families_idxs.insert(_queue_family_idxs.transfer.value());
+
+    if(_queue_family_idxs.compute.has_value())
+        unique_queue_families_idxs.insert(_queue_family_idxs.compute.value());
+
     float queue_priority = 1.0f;
 
     for(auto queue_family_idx : unique_queue_families_idxs) {
@@ -349,14 +478,56 @@ bool VkCore::setup_logical_device(VkPhysicalDevice physical_device, VkDevice *lo
     VkPhysicalDeviceFeatures device_features{};
     vkGetPhysicalDeviceFeatures(physical_device, &device_features);
 
+    std::vector<const char*> extensions = _device_req_extensions;
+    query_device_features(physical_device, &extensions);
+
+    // optional feature structs are chained in front of each other, only the ones the device supports
+    void *feature_chain_ptr = nullptr;
+
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing_features{};
+    indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    if(_device_features.descriptor_indexing) {
+        indexing_features.runtimeDescriptorArray                        = VK_TRUE;
+        indexing_features.descriptorBindingPartiallyBound               = VK_TRUE;
+        indexing_features.descriptorBindingUpdateUnusedWhilePending     = VK_TRUE;
+        indexing_features.descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE;
+        indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        indexing_features.shaderSampledImageArrayNonUniformIndexing     = VK_TRUE;
+
+        indexing_features.pNext = feature_chain_ptr;
+        feature_chain_ptr = &indexing_features;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+    timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    if(_device_features.timeline_semaphore) {
+        timeline_features.timelineSemaphore = VK_TRUE;
+
+        timeline_features.pNext = feature_chain_ptr;
+        feature_chain_ptr = &timeline_features;
+    }
+
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR rendering_features{};
+    rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+    if(_device_features.dynamic_rendering) {
+        rendering_features.dynamicRendering = VK_TRUE;
+
+        rendering_features.pNext = feature_chain_ptr;
+        feature_chain_ptr = &rendering_features;
+    }
+
     VkDeviceCreateInfo device_create_info{};
     device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_create_info.pNext = feature_chain_ptr;
 
     device_create_info.pQueueCreateInfos = queue_create_infos.data();
     device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
 
-    device_create_info.ppEnabledExtensionNames = _device_req_extensions.data();
-    device_create_info.enabledExtensionCount = static_cast<uint32_t>(_device_req_extensions.size());
+    device_create_info.ppEnabledExtensionNames = extensions.data();
+    device_create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 
     device_create_info.pEnabledFeatures = &device_features;
 
@@ -370,6 +541,111 @@ bool VkCore::setup_logical_device(VkPhysicalDevice physical_device, VkDevice *lo
     return vkCreateDevice(physical_device, &device_create_info, nullptr, logical_device_ptr) == VK_SUCCESS;
 }
 
+void VkCore::query_device_features(VkPhysicalDevice physical_device, std::vector<const char*> *extensions_ptr) {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physical_device, &props);
+
+    _device_features = DeviceFeatures{};
+    _device_features.api_version = std::min(_instance_api_version, props.apiVersion);
+
+    spdlog::info("device supports vulkan {}.{}, using {}.{}",
+                 VK_API_VERSION_MAJOR(props.apiVersion), VK_API_VERSION_MINOR(props.apiVersion),
+                 VK_API_VERSION_MAJOR(_device_features.api_version), VK_API_VERSION_MINOR(_device_features.api_version));
+
+    // vulkan 1.0 features, setup_logical_device enables every one the device supports
+    VkPhysicalDeviceFeatures base_features{};
+    vkGetPhysicalDeviceFeatures(physical_device, &base_features);
+
+    _device_features.multi_draw_indirect = base_features.multiDrawIndirect == VK_TRUE;
+
+    // the extension has no feature struct, and keeps working on 1.2 devices where the count draws became core
+    if(physical_device_extension_exists(physical_device, nullptr, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+        _device_features.draw_indirect_count = true;
+        extensions_ptr->push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    spdlog::info("multi draw indirect: {}, draw indirect count: {}",
+                 _device_features.multi_draw_indirect ? "enabled" : "unavailable",
+                 _device_features.draw_indirect_count ? "enabled" : "unavailable");
+
+    // every optional feature is queried through vkGetPhysicalDeviceFeatures2, which is core from 1.1 on
+    if(_device_features.api_version < VK_API_VERSION_1_1)
+        return;
+
+    bool core_1_2 = _device_features.api_version >= VK_API_VERSION_1_2;
+
+    // core in 1.2, an extension on top of 1.1 whose maintenance3 dependency is already core there
+    bool has_indexing = core_1_2 ||
+        physical_device_extension_exists(physical_device, nullptr, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+
+    if(has_indexing) {
+        VkPhysicalDeviceDescriptorIndexingFeatures indexing_features{};
+        indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &indexing_features;
+
+        vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+        _device_features.descriptor_indexing =
+            indexing_features.runtimeDescriptorArray &&
+            indexing_features.descriptorBindingPartiallyBound &&
+            indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+            indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+            indexing_features.descriptorBindingStorageBufferUpdateAfterBind &&
+            indexing_features.shaderSampledImageArrayNonUniformIndexing;
+
+        if(_device_features.descriptor_indexing && core_1_2 == false)
+            extensions_ptr->push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+
+    spdlog::info("descriptor indexing: {}", _device_features.descriptor_indexing ? "enabled" : "unavailable");
+
+    bool has_timeline = core_1_2 ||
+        physical_device_extension_exists(physical_device, nullptr, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+
+    if(has_timeline) {
+        VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+        timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &timeline_features;
+
+        vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+        _device_features.timeline_semaphore = timeline_features.timelineSemaphore == VK_TRUE;
+
+        if(_device_features.timeline_semaphore && core_1_2 == false)
+            extensions_ptr->push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
+    spdlog::info("timeline semaphores: {}", _device_features.timeline_semaphore ? "enabled" : "unavailable");
+
+    // core only from 1.3 on, its depth stencil resolve and create render pass 2 dependencies are core in 1.2
+    bool has_dynamic_rendering = core_1_2 &&
+        physical_device_extension_exists(physical_device, nullptr, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+
+    if(has_dynamic_rendering) {
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR rendering_features{};
+        rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &rendering_features;
+
+        vkGetPhysicalDeviceFeatures2(physical_device, &features);
+
+        _device_features.dynamic_rendering = rendering_features.dynamicRendering == VK_TRUE;
+
+        if(_device_features.dynamic_rendering)
+            extensions_ptr->push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
+
+    spdlog::info("dynamic rendering: {}", _device_features.dynamic_rendering ? "enabled" : "unavailable");
+}
+
 VkSurfaceFormatKHR get_best_swap_surface_format(const std::vector<VkSurfaceFormatKHR> *surface_formats_ptr) {
     for(const auto &surface_format : *surface_formats_ptr) {
         // best format hardcoded
@@ -382,16 +658,44 @@ VkSurfaceFormatKHR get_best_swap_surface_format(const std::vector<VkSurfaceForma
     return (*surface_formats_ptr)[0];
 }
 
-VkPresentModeKHR get_best_swap_present_mode(const std::vector<VkPresentModeKHR> *present_mode_ptr) {
-    for(const auto &present_mode : *present_mode_ptr) {
-        // best format hardcoded
-        if(present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
-            return present_mode;
+VkPresentModeKHR get_best_swap_present_mode(const std::vector<VkPresentModeKHR> *present_mode_ptr,
+                                            PresentPolicy policy) {
+    // the preferred mode first, each following one is the closest match left
+    std::vector<VkPresentModeKHR> candidates{};
+
+    switch(policy) {
+        case PresentPolicy::IMMEDIATE:
+            candidates = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+            break;
+        case PresentPolicy::MAILBOX:
+            candidates = { VK_PRESENT_MODE_MAILBOX_KHR };
+            break;
+        case PresentPolicy::FIFO_RELAXED:
+            candidates = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+            break;
+        case PresentPolicy::FIFO:
+            break;
+    }
+
+    for(VkPresentModeKHR candidate : candidates) {
+        if(std::find(present_mode_ptr->begin(), present_mode_ptr->end(), candidate) != present_mode_ptr->end())
+            return candidate;
     }
 
+    // the only mode every surface has to support
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+const char* get_present_mode_name(VkPresentModeKHR present_mode) {
+    switch(present_mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:      return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:         return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+        default:                               return "other";
+    }
+}
+
 VkExtent2D get_glfw_best_swap_extent(GLFWwindow *window_ptr, const VkSurfaceCapabilitiesKHR *capabilities_ptr) {
     if(capabilities_ptr->currentExtent.width != std::numeric_limits<uint32_t>::max())
         return capabilities_ptr->currentExtent;
@@ -412,7 +716,7 @@ VkExtent2D get_glfw_best_swap_extent(GLFWwindow *window_ptr, const VkSurfaceCapa
     return extent;
 }
 
-bool VkCore::create_swap_chain(GLFWwindow *window_ptr) {
+bool VkCore::create_swap_chain(GLFWwindow *window_ptr, VkSwapchainKHR old_swap_chain) {
     SwapChainSupportInfo support_info{};
 
     if(_device_manager_ptr->get_swap_chain_support(_surface, &support_info) == false)
@@ -422,20 +726,29 @@ bool VkCore::create_swap_chain(GLFWwindow *window_ptr) {
     VkSurfaceCapabilitiesKHR &capabilities = support_info.capabilities;
 
     VkSurfaceFormatKHR surface_format = get_best_swap_surface_format(&support_info.formats);
-    VkPresentModeKHR   present_mode   = get_best_swap_present_mode(&support_info.present_modes);
+    VkPresentModeKHR   present_mode   = get_best_swap_present_mode(&support_info.present_modes, _present_policy);
     VkExtent2D         extent         = get_glfw_best_swap_extent(window_ptr, &support_info.capabilities);
 
     _chosen_img_format = surface_format.format;
     _chosen_extent = extent;
+    _present_mode = present_mode;
+
+    spdlog::info("present mode: {}", get_present_mode_name(present_mode));
 
-    uint32_t image_count = capabilities.minImageCount + 1;
+    uint32_t image_count = _desired_img_count != 0 ? _desired_img_count : capabilities.minImageCount + 1;
+    image_count = std::max(image_count, capabilities.minImageCount);
+
+    // a max of 0 means the surface has no upper limit
     if(capabilities.maxImageCount > 0 && image_count > capabilities.maxImageCount)
         image_count = capabilities.maxImageCount;
+
+    spdlog::info("asking for {} swap chain images, the surface allows {} to {}", image_count,
+                 capabilities.minImageCount, capabilities.maxImageCount);
     
     VkSwapchainCreateInfoKHR create_info{};
     create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     create_info.surface = _surface;
-    create_info.minImageCount = capabilities.minImageCount;
+    create_info.minImageCount = image_count;
     create_info.imageFormat = surface_format.format;
     create_info.imageColorSpace = surface_format.colorSpace;
     create_info.imageExtent = extent;
@@ -464,18 +777,22 @@ bool VkCore::create_swap_chain(GLFWwindow *window_ptr) {
     create_info.presentMode = present_mode;
     create_info.clipped = VK_TRUE;
 
-    // when window resize create new swap chain(not supported yet)
-    create_info.oldSwapchain = VK_NULL_HANDLE;
+    // lets the driver reuse the old swap chain's resources, images still queued for presenting stay valid
+    create_info.oldSwapchain = old_swap_chain;
 
     return _swap_chain.init(_device_manager_ptr->get_logical(), &create_info, nullptr);
 }
 
-bool VkCore::recreate_swap_chain(GLFWwindow *window_ptr) {
-    vkDeviceWaitIdle(_logical_device);
+bool VkCore::recreate_swap_chain(GLFWwindow *window_ptr, VkSwapchainKHR *old_swap_chain_ptr) {
+    VkSwapchainKHR old_swap_chain = _swap_chain.get_raw_handle_ref();
+    *old_swap_chain_ptr = VK_NULL_HANDLE;
 
-    destroy_swap_chain();
+    // on failure the old swap chain is retired all the same, but stays owned by _swap_chain and is destroyed with it
+    if(create_swap_chain(window_ptr, old_swap_chain) == false)
+        return false;
 
-    return create_swap_chain(window_ptr);
+    *old_swap_chain_ptr = old_swap_chain;
+    return true;
 }
 
 void VkCore::destroy_swap_chain() {
@@ -493,4 +810,24 @@ VkQueue& VkCore::get_present_queue_ref() {
     return _present_queue;
 }
 
+VkQueue& VkCore::get_transfer_queue_ref() {
+    return _transfer_queue;
+}
+
+uint32_t VkCore::get_transfer_queue_family() const {
+    return _queue_family_idxs.transfer.value_or(_queue_family_idxs.graphics.value());
+}
+
+VkQueue& VkCore::get_compute_queue_ref() {
+    return _compute_queue;
+}
+
+uint32_t VkCore::get_compute_queue_family() const {
+    return _queue_family_idxs.compute.value_or(_queue_family_idxs.graphics.value());
+}
+
+bool VkCore::has_async_compute() const {
+    return _queue_family_idxs.compute.has_value();
+}
+
 }; // namespace fl
@@ -124,5 +124,22 @@ bool physical_device_extension_exists(VkPhysicalDevice device, const char *layer
     return false;
 }
 
+bool find_depth_format(VkPhysicalDevice device, VkFormat *format_ptr) {
+    // no stencil is needed, D16 is the only one of these the spec guarantees
+    const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM };
+
+    for(VkFormat format : candidates) {
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(device, format, &props);
+
+        if(props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            *format_ptr = format;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 } // namespace fl
 
@@ -3,9 +3,29 @@
 #define _FL_APPLICATION_H
 
 #include <fl_pipeline.hpp>
+#include <fl_pipeline_cache.hpp>
+#include <fl_pipeline_builder.hpp>
+#include <fl_thread_pool.hpp>
+#include <fl_parallel_recorder.hpp>
+#include <fl_frame_context.hpp>
+#include <fl_sprite_batcher.hpp>
+#include <fl_opaque_queue.hpp>
+#include <fl_mesh.hpp>
 #include <fl_vk_core.hpp>
+#include <fl_gpu_profiler.hpp>
+#include <fl_upload_service.hpp>
+#include <fl_bindless_heap.hpp>
+#include <fl_uniform_ring.hpp>
+#include <fl_gpu_culler.hpp>
+#include <fl_compute_queue.hpp>
+#include <fl_queue_timeline.hpp>
+#include <fl_frame_limiter.hpp>
+#include <fl_deletion_queue.hpp>
+#include <fl_render_graph.hpp>
+#include <fl_texture.hpp>
 
 #include <string>
+#include <functional>
 
 #include <vulkan/vulkan.h>
 
@@ -13,13 +33,50 @@ struct GLFWwindow;
 
 namespace fl {
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// frames the cpu may record ahead of the gpu, more smooths out spikes at the cost of input latency
+const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+/// timings of a single draw_frame call, all in milliseconds
+struct FrameStats {
+    double cpu_frame_ms  = 0.0; // the whole draw_frame call
+    double fence_wait_ms = 0.0; // blocked until the frame slot is free, on its fence or timeline value
+    double acquire_ms    = 0.0; // blocked in vkAcquireNextImageKHR
+
+    // low latency mode only, blocked on the previous frame before input was sampled. Not part of cpu_frame_ms
+    double latency_wait_ms = 0.0;
+
+    // frame limiter only, blocked before the frame started and how far that wake up missed its deadline
+    double pacing_wait_ms   = 0.0;
+    double pacing_jitter_ms = 0.0;
+
+    // gpu time of the frame that last used this frame slot, frames in flight frames ago
+    double gpu_ms    = 0.0;
+    bool   gpu_valid = false;
+};
+
+/// describes how much is drawn per frame, used to scale the workload when benchmarking
+struct SceneConfig {
+    uint32_t draw_count     = 1; // amount of draw calls per frame
+    uint32_t instance_count = 1; // instances of the quad per draw call
+    uint32_t sprite_count   = 0; // quads drawn through the sprite batcher, rewritten every frame
+
+    // the draws are culled and emitted by a compute pass, recording them costs the same for any draw_count
+    bool gpu_culling = false;
+};
+
+/// constants every shader can read from the uniform ring, laid out like the std140 block in sprite.vert
+struct FrameUniforms {
+    float camera_offset[2] = { 0.0f, 0.0f }; // device coordinates, subtracted before zooming
+    float camera_zoom = 1.0f;
+    float time        = 0.0f; // advances by the same step the sprite rotation does
+};
 
 /// Application is an abstraction layer that handles the major loop and handles
 /// both initializaztion and generation of the window, it is essentially the entire engine entry
 class Application {
 public:
-    Application(int width, int height, const std::string &name);
+    // a headless application never creates a window, it renders into offscreen images instead
+    Application(int width, int height, const std::string &name, bool headless = false);
     ~Application();
 
     Application(Application&) = delete;
@@ -29,36 +86,176 @@ public:
 
     int run();
 
+    // draws a fixed amount of frames and waits for the device to finish, works both windowed and headless,
+    // on_frame is called with the timings of every frame drawn
+    bool run_frames(uint32_t frame_count, const std::function<void(const FrameStats&)> &on_frame = nullptr);
+
+    // a scene with gpu_culling has to be set after init, the culled objects are uploaded right away
+    void set_scene(const SceneConfig &scene);
+
+    // how many frames the cpu records ahead of the gpu, at least 1, must be set before init
+    void set_frames_in_flight(uint32_t count);
+
+    // swap chain images to ask for, clamped to what the surface supports. 0 picks one above the surface minimum,
+    // must be set before init
+    void set_swap_chain_img_count(uint32_t count);
+
+    // waits for the previous frame to finish before input is sampled, so the frame that is built reacts to the
+    // freshest input. Trades throughput for input to photon latency, can be toggled at any time
+    void set_low_latency(bool enable);
+
+    // how frames are presented, MAILBOX by default. FIFO caps the frame rate to the display instead of rendering
+    // frames that are never shown, must be set before init
+    void set_present_policy(PresentPolicy policy);
+
+    // holds frames to a fixed rate on the cpu, windowed and headless alike. 0 turns it off, can be set at any time
+    void set_target_fps(double fps);
+
+    // begin the main pass on the swap chain views through VK_KHR_dynamic_rendering when the device supports it,
+    // so nothing has to be rebuilt for the render pass on resize. On by default, must be set before init
+    void set_dynamic_rendering(bool enable);
+
+    // draws the scene into a depth attachment that is never stored, its draws layered and sorted front to back so
+    // fragments behind the nearest layer are rejected before shading. Off by default, must be set before init
+    void set_depth_buffer(bool enable);
+
+    // collect pipeline statistics for every profiled pass, must be set before init
+    void set_pipeline_statistics(bool enable);
+
+    // record draws into secondary command buffers across the worker threads, on by default, must be set before init
+    void set_parallel_recording(bool enable);
+
+    // run compute passes on a compute only queue family when the device has one, on by default, must be set before init
+    void set_async_compute(bool enable);
+
+    // track frame completion with one timeline semaphore per queue instead of fences when the device supports it,
+    // on by default, must be set before init
+    void set_timeline_semaphores(bool enable);
+
+    // the mode the swap chain was created with, which may have fallen back from the policy. Meaningless when headless
+    VkPresentModeKHR get_present_mode() const;
+
+    // whether draws are really recorded on the workers, false when disabled or unsupported. Valid after init
+    bool is_parallel_recording() const;
+
+    // whether the scene is really culled on the gpu, false when the culler is unavailable. Valid after set_scene
+    bool is_gpu_culling() const;
+
+    // whether compute passes really run on a compute only queue, false when disabled or the device has none. Valid after init
+    bool is_async_compute() const;
+
+    // whether frames are really tracked with timeline semaphores, false when disabled or unsupported. Valid after init
+    bool is_timeline_sync() const;
+
+    // whether the main pass really uses dynamic rendering, false when it fell back to a render pass. Valid after init
+    bool is_dynamic_rendering() const;
+
+    // whether the main pass really has a depth attachment, false when disabled or no depth format is supported. Valid after init
+    bool has_depth_buffer() const;
+
+    // per pass gpu results that arrived with the last frame, only meaningful when its FrameStats::gpu_valid
+    const std::vector<GpuPassStats>* get_gpu_pass_stats_ptr() const;
+
 
 private:
     int init_glfw_window();
 
     bool recreate_swap_chain_and_views();
 
+    // a batch that only waits, so binary semaphores a dropped frame signaled are consumed and can be signaled again.
+    // It signals nothing and leaves the frame fence alone, the acquired image stays unpresented
+    void drain_waits(const VkSemaphore *semas, const VkPipelineStageFlags *stages, const uint64_t *values,
+                     uint32_t count);
+
     void set_viewport_extents_scissors(VkExtent2D extent);
 
     bool setup_swap_chain_views();
 
     bool setup_swap_chain_frame_buffers();
 
-    bool setup_render_pass(Swapchain *swap_chain_ptr, VkDevice device);
+    bool setup_render_pass(VkFormat img_format, VkDevice device);
+
+    // only when enabled and supported, setup_render_pass is the fallback
+    bool setup_dynamic_rendering();
+
+    // declares the frame's passes and compiles them, again whenever the swap chain or the cull pass changes
+    bool build_render_graph();
+
+    // the draws and sprites into the backbuffer, recorded by the render graph
+    bool record_main_pass(VkCommandBuffer cmd_buf, uint32_t img_idx);
+
+    // begins and ends the main pass instance, through the render pass or dynamic rendering
+    void begin_main_pass(VkCommandBuffer cmd_buf, uint32_t img_idx, bool secondaries);
+    void end_main_pass(VkCommandBuffer cmd_buf);
 
-    bool setup_command_pool();
-    bool setup_command_buffers();
+    bool setup_frame_context();
 
     bool record_command_buffer(VkCommandBuffer cmd_buf, uint32_t img_idx);
 
+    // binds the state every draw needs and records count draws of the opaque queue from first on, used both inline
+    // and from workers
+    void record_draws(VkCommandBuffer cmd_buf, uint32_t first, uint32_t count) const;
+
+    // one draw per scene draw, each on its own layer when there is a depth attachment
+    void fill_opaque_queue();
+
+    // fills the sprite batcher with the scene's sprites, animated so every frame writes fresh instance data
+    void emit_scene_sprites();
+
+    // the compute pipeline and buffers behind SceneConfig::gpu_culling, only fails when cull.comp is missing
+    bool setup_gpu_culler();
+
+    // uploads the scene's draws as cull objects, false when they are drawn with cpu recorded draws instead
+    bool setup_scene_culling(const SceneConfig &scene);
+
+    // pushes this frame's FrameUniforms into the uniform ring
+    void push_frame_uniforms();
+
+    // binds the ring at this frame's uniforms for the sprite pipelines
+    void bind_frame_uniforms(VkCommandBuffer cmd_buf) const;
+
+    // the sprites always go into a secondary of their own when recording in parallel
+    bool record_sprites_secondary(const VkCommandBufferInheritanceInfo &inheritance);
+
+    bool setup_parallel_recording();
+
     bool setup_synchronize_objs();
 
-    bool setup_vertex_buffer();
+    bool setup_upload_service();
+
+    // only with a compute only family, resources created afterwards are shared with it
+    bool setup_compute_queue();
+
+    // records the culling dispatch, either into the frame command buffer or an async compute one
+    void record_cull(VkCommandBuffer cmd_buf);
+
+    // culls on the compute queue and submits right away. A binary semaphore is waited on only once, so a pending
+    // upload semaphore is forwarded through the compute submit and the graphics submit waits on the returned one
+    VkSemaphore submit_async_cull(VkSemaphore upload_sema, VkPipelineStageFlags *wait_stages_ptr,
+                                  uint64_t *wait_value_ptr);
+
+    // deduplicates the quad corners into indexed geometry and stages it for upload
+    bool setup_quad_mesh();
+
+    // only when the device supports descriptor indexing, has to run before any pipeline is built
+    bool setup_bindless_heap();
+
+    // reserves its set in the layout cache, so has to run before any pipeline is built as well
+    bool setup_uniform_ring();
+
+    // a procedural checker texture registered in the bindless heap, staged for upload
+    bool setup_sprite_texture();
 
-    bool alloc_bind_vertex_buffer_mem();
+    // paces the frame start, then waits for the previous frame in low latency mode. Runs before input is sampled
+    void begin_frame_wait();
+
+    // low latency mode only, blocks until every submitted frame finished
+    void wait_for_previous_frame();
 
     bool draw_frame();
     
     void destroy_views_and_frame_buffers();
 
-    bool find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags props, uint32_t *mem_type_ptr);
 
 
     VkViewport _viewport;
@@ -66,17 +263,40 @@ private:
 
     std::vector<VkSemaphore> _img_avail_semas;
     std::vector<VkSemaphore> _render_fin_semas;
-    std::vector<VkFence>     _rendering_fences;
+    std::vector<VkFence>     _rendering_fences; // empty when frames are tracked by the timeline
+
+    QueueTimeline         _graphics_timeline;
+    std::vector<uint64_t> _frame_timeline_values{}; // what each frame slot's last submit signals
+
+    bool _enable_timeline = true;
+    bool _use_timeline    = false; // enabled and supported by the device
+
+    VkRenderPass _render_pass = VK_NULL_HANDLE; // stays null when rendering dynamically
+
+    bool _enable_dynamic_rendering = true;
+    bool _dynamic_rendering        = false; // enabled, supported and its entry points loaded
 
-    VkRenderPass _render_pass = VK_NULL_HANDLE;
+    bool     _enable_depth = false;
+    VkFormat _depth_format = VK_FORMAT_UNDEFINED; // stays undefined without a depth attachment
+
+    PFN_vkCmdBeginRenderingKHR _cmd_begin_rendering = nullptr;
+    PFN_vkCmdEndRenderingKHR   _cmd_end_rendering   = nullptr;
 
     std::vector<VkImageView>   _swpchn_views{};
     std::vector<VkImage>       _swpchn_imgs{};
     std::vector<VkFramebuffer> _swpchn_frame_buffers{};
 
-    VkCommandPool _cmd_pool = VK_NULL_HANDLE;
-    std::vector<VkCommandBuffer> _cmd_buffers;
+    FrameContext _frame_context;
+
+    // swap chain resources replaced while frames were still in flight
+    DeletionQueue _deletion_queue;
+
+    RenderGraph      _render_graph;
+    RenderResourceId _backbuffer    = INVALID_RENDER_ID;
+    RenderResourceId _depth         = INVALID_RENDER_ID;
+    uint32_t         _frame_img_idx = 0; // the image the passes of the recording frame render into
 
+    // triangle soup, the shared corners are merged into 4 vertices when the mesh is built
     const std::vector<Vertex> _verticies {
         { {-.5f, -.5f}, {1.f, .0f, .0f} },
         { {.5f,  -.5f}, {1.f, 1.f, 1.f} },
@@ -87,14 +307,32 @@ private:
         { {-.5f, .5f}, {0.f, 1.f, .0f} }
     };
 
-    VkMemoryRequirements _vert_buf_mem_req;
+    Mesh _quad_mesh;
+    OpaqueQueue _opaque_queue;
+
+    uint32_t _frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT;
+    size_t   _current_frame = 0;
+
+    bool   _low_latency     = false;
+    double _latency_wait_ms = 0.0; // measured before the frame starts, handed to its FrameStats
 
+    FrameLimiter _frame_limiter;
 
-    VkBuffer _vertex_buf = VK_NULL_HANDLE;
-    VkDeviceMemory _vertex_buf_mem;
-    void *_vertex_buf_mapped;
+    uint64_t _frame_number = 0;
 
-    size_t _current_frame = 0;
+    SceneConfig _scene{};
+    FrameStats  _frame_stats{};
+
+    bool _enable_pipeline_stats = false;
+
+    bool _enable_async_compute = true;
+    bool _async_compute        = false; // enabled and the device has a compute only family
+
+    bool _enable_parallel_recording = true;
+    bool _parallel_recording        = false; // enabled and supported by the device
+
+    std::vector<VkCommandBuffer> _secondary_cmd_bufs{};
+    std::vector<GpuPassStats> _gpu_pass_stats{};
 
     #ifdef NDEBUG
         const bool _enable_validation_layers = false;
@@ -105,14 +343,61 @@ private:
     int _width, _height;
     std::string _name;
 
+    bool _headless;
+
     GLFWwindow *_win_ptr = nullptr;
 
     VkCore _vk_core;
 
+    GpuProfiler _gpu_profiler;
+
+    // declared before everything handing work to it, so it is destroyed after them
+    ThreadPool _thread_pool;
+
+    ShaderLibrary   _shader_library;
+    LayoutCache     _layout_cache;
+    PipelineCache   _pipeline_cache;
+    PipelineBuilder _pipeline_builder;
+
+    ParallelRecorder _parallel_recorder;
+
+    SpriteBatcher _sprite_batcher;
+    bool _sprites_available = false; // the sprite pipeline built, which needs the compiled sprite shaders
+
+    UploadService _upload_service;
+
+    BindlessHeap _bindless_heap;
+    bool _bindless_available = false;
+
+    ComputeQueue _compute_queue;
+
+    GpuCuller _gpu_culler;
+    bool _gpu_culler_available = false;
+    bool _gpu_culling = false; // the scene asked for it and the culler is available
+
+    UniformRing _uniform_ring;
+    uint32_t    _frame_uniform_offset = 0; // where this frame's FrameUniforms were pushed
+
+    Texture  _sprite_texture;
+    uint32_t _sprite_texture_idx = INVALID_BINDLESS_IDX;
+
     Pipeline _pipeline {
         "vendor/shaders/demo_shader.vert.spv",
         "vendor/shaders/demo_shader.frag.spv"
     };
+
+    Pipeline _sprite_pipeline {
+        "vendor/shaders/sprite.vert.spv",
+        "vendor/shaders/sprite.frag.spv",
+        SpriteBatcher::get_input_desc()
+    };
+
+    // built instead of the plain sprite pipeline when the bindless heap is available
+    Pipeline _bindless_sprite_pipeline {
+        "vendor/shaders/sprite.vert.spv",
+        "vendor/shaders/sprite_bindless.frag.spv",
+        SpriteBatcher::get_input_desc()
+    };
 };
 
 
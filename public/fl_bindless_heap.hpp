@@ -0,0 +1,89 @@
+#pragma once
+#ifndef _FL_BINDLESS_HEAP_H
+#define _FL_BINDLESS_HEAP_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <mutex>
+#include <vector>
+
+namespace fl {
+
+// the set every pipeline layout reserves for the heap, kept lowest so it survives every pipeline switch
+const uint32_t BINDLESS_SET = 0;
+
+const uint32_t BINDLESS_TEXTURE_BINDING = 0; // combined image samplers, sampler2D textures[] in glsl
+const uint32_t BINDLESS_BUFFER_BINDING  = 1; // storage buffers
+
+const uint32_t DEFAULT_BINDLESS_TEXTURE_COUNT = 4096;
+const uint32_t DEFAULT_BINDLESS_BUFFER_COUNT  = 1024;
+
+// handed out when the heap is full, shaders treat it as no resource
+const uint32_t INVALID_BINDLESS_IDX = ~0u;
+
+/// BindlessHeap is one large descriptor set holding every texture and storage buffer, shaders pick resources by
+/// index from push constants or instance data. It is bound once per command buffer and written with update after
+/// bind, so adding a resource or changing which one a draw uses never breaks a batch or rebinds anything.
+/// Needs the descriptor indexing features, safe to use from multiple threads
+class BindlessHeap {
+public:
+    BindlessHeap();
+    ~BindlessHeap();
+
+    BindlessHeap(BindlessHeap&) = delete;
+    BindlessHeap& operator=(BindlessHeap&) = delete;
+
+    // the capacities are clamped to the update after bind limits of the device
+    bool init(VkPhysicalDevice physical, VkDevice logical,
+              uint32_t texture_capacity = DEFAULT_BINDLESS_TEXTURE_COUNT,
+              uint32_t buffer_capacity  = DEFAULT_BINDLESS_BUFFER_COUNT);
+
+    void destroy();
+
+    // the image has to be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when sampled, without a sampler the
+    // heap's linear repeating one is used
+    uint32_t add_texture(VkImageView view, VkSampler sampler = VK_NULL_HANDLE);
+    uint32_t add_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // the slot is reused by the next add, no frame in flight may still read it
+    void remove_texture(uint32_t idx);
+    void remove_buffer(uint32_t idx);
+
+    // binds the heap to BINDLESS_SET, any layout from the LayoutCache it was reserved in works
+    void bind(VkCommandBuffer cmd_buf, VkPipelineBindPoint bind_point, VkPipelineLayout layout) const;
+
+    VkDescriptorSetLayout get_raw_set_layout_handle() const;
+    VkDescriptorSet get_raw_set_handle() const;
+
+    uint32_t get_texture_count() const;
+    uint32_t get_buffer_count() const;
+
+private:
+    /// indices of one binding, freed ones are reused before the next new one
+    struct SlotAllocator {
+        uint32_t capacity = 0;
+        uint32_t next     = 0;
+        std::vector<uint32_t> freed{};
+
+        uint32_t acquire();
+        void release(uint32_t idx);
+        uint32_t get_used() const;
+    };
+
+    SlotAllocator _texture_slots{};
+    SlotAllocator _buffer_slots{};
+
+    VkDescriptorSetLayout _set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool      _pool = VK_NULL_HANDLE;
+    VkDescriptorSet       _set  = VK_NULL_HANDLE;
+
+    VkSampler _default_sampler = VK_NULL_HANDLE;
+
+    mutable std::mutex _mutex;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_BINDLESS_HEAP_H
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef _FL_COMPUTE_QUEUE_H
+#define _FL_COMPUTE_QUEUE_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_frame_context.hpp>
+#include <fl_queue_timeline.hpp>
+
+#include <vector>
+
+namespace fl {
+
+// stages of the graphics submit that wait on async compute results, covers indirect, vertex and fragment reads
+const VkPipelineStageFlags COMPUTE_WAIT_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT  |
+                                                 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT   |
+                                                 VK_PIPELINE_STAGE_VERTEX_SHADER_BIT  |
+                                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+/// ComputeQueue records and submits work on the async compute family, so culling, simulation or post processing
+/// overlaps with raster work on the graphics queue. Every frame in flight has its own command buffers, fence and
+/// a semaphore the graphics submit waits on. Resources it shares with the graphics queue need concurrent sharing
+/// over both families, see UploadService::add_sharing_family. With timeline semaphores the fences and per frame
+/// semaphores are replaced by a single QueueTimeline
+class ComputeQueue {
+public:
+    ComputeQueue();
+    ~ComputeQueue();
+
+    ComputeQueue(ComputeQueue&) = delete;
+    ComputeQueue& operator=(ComputeQueue&) = delete;
+
+    bool init(VkDevice logical, uint32_t family_idx, VkQueue queue, uint32_t frame_count, bool use_timeline = false);
+
+    // waits for every submission in flight before releasing anything
+    void destroy();
+
+    // waits for the frame's previous submission, then resets its command buffers
+    bool begin_frame(size_t frame_idx);
+
+    // a primary command buffer of the current frame, already begun. Ended by submit
+    bool begin_recording(VkCommandBuffer *cmd_buf_ptr);
+
+    // the next submit waits on the semaphore before the given stages run
+    void add_wait(VkSemaphore sema, VkPipelineStageFlags stages);
+
+    // submits everything recorded since begin_frame, the returned semaphore must be waited on with
+    // COMPUTE_WAIT_STAGES by the very next graphics submit. VK_NULL_HANDLE when there was nothing to submit.
+    // A timeline semaphore has to be waited on for the value written to value_ptr, binary ones write 0
+    VkSemaphore submit(uint64_t *value_ptr = nullptr);
+
+    uint32_t get_family_idx() const;
+
+private:
+    struct Frame {
+        VkFence     fence    = VK_NULL_HANDLE;
+        VkSemaphore finished = VK_NULL_HANDLE;
+
+        uint64_t timeline_value = 0; // signaled by the frame's last submit, only with the timeline
+    };
+
+    FrameContext _frame_context;
+
+    std::vector<Frame> _frames{};
+    size_t _frame_idx = 0;
+
+    QueueTimeline _timeline;
+    bool _use_timeline = false;
+
+    std::vector<VkCommandBuffer> _recorded{};
+
+    std::vector<VkSemaphore>          _wait_semas{};
+    std::vector<VkPipelineStageFlags> _wait_stages{};
+
+    VkQueue  _queue = VK_NULL_HANDLE;
+    uint32_t _family_idx = 0;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_COMPUTE_QUEUE_H
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef _FL_DELETION_QUEUE_H
+#define _FL_DELETION_QUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace fl {
+
+/// DeletionQueue defers destroying objects that frames still in flight may use. A retired object is destroyed
+/// once every frame slot began again after it was retired, by then each submission that could reference it
+/// has been waited on through its slot's fence or timeline value, so nothing has to wait for the device to idle
+class DeletionQueue {
+public:
+    DeletionQueue();
+    ~DeletionQueue();
+
+    DeletionQueue(DeletionQueue&) = delete;
+    DeletionQueue& operator=(DeletionQueue&) = delete;
+
+    bool init(uint32_t frame_count);
+
+    // runs every pending destroy right away, the device must be idle
+    void destroy();
+
+    // call once the slot's previous submission is known to be finished, runs the destroys that became safe
+    void begin_frame(uint32_t frame_idx);
+
+    void retire(std::function<void()> &&destroy_func);
+
+    size_t get_pending_count() const;
+
+private:
+    struct Retired {
+        uint64_t serial; // begin_frame calls made before it was retired
+        std::function<void()> destroy_func;
+    };
+
+    std::deque<Retired> _pending{};
+
+    uint64_t _serial = 0;
+    std::vector<uint64_t> _slot_serials{}; // the serial each slot last began at
+};
+
+} // namespace fl
+
+#endif // _FL_DELETION_QUEUE_H
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef _FL_FRAME_CONTEXT_H
+#define _FL_FRAME_CONTEXT_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+namespace fl {
+
+/// FrameContext owns one transient command pool per frame in flight. Instead of resetting command buffers one by one,
+/// which is the slow path on many drivers, the whole pool of a frame is reset at once when that frame starts again.
+/// Any number of command buffers can be taken per frame, they are handed out from a linear list that is reused
+class FrameContext {
+public:
+    FrameContext();
+    ~FrameContext();
+
+    FrameContext(FrameContext&) = delete;
+    FrameContext& operator=(FrameContext&) = delete;
+
+    bool init(VkDevice logical, uint32_t queue_family_idx, uint32_t frame_count);
+
+    void destroy();
+
+    // resets the frame's pool and makes it current, only call after the frame's fence signaled
+    bool begin_frame(size_t frame_idx);
+
+    // the next unused command buffer of the current frame, valid until the frame begins again
+    bool get_cmd_buf(VkCommandBufferLevel level, VkCommandBuffer *cmd_buf_ptr);
+
+    size_t get_frame_idx() const;
+
+private:
+    struct CmdBufList {
+        std::vector<VkCommandBuffer> cmd_bufs{};
+        uint32_t used = 0;
+    };
+
+    struct Frame {
+        VkCommandPool pool = VK_NULL_HANDLE;
+
+        CmdBufList primaries{};
+        CmdBufList secondaries{};
+    };
+
+    std::vector<Frame> _frames{};
+    size_t _frame_idx = 0;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_FRAME_CONTEXT_H
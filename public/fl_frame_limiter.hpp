@@ -0,0 +1,58 @@
+#pragma once
+#ifndef _FL_FRAME_LIMITER_H
+#define _FL_FRAME_LIMITER_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace fl {
+
+/// FrameLimiter holds the cpu to a target frame rate independent of the present mode, so it also paces
+/// headless runs. Frames start on a fixed grid of deadlines, the wait sleeps for most of the gap and spins
+/// the rest, since a plain sleep overshoots by up to the scheduler's granularity
+class FrameLimiter {
+public:
+    FrameLimiter();
+
+    FrameLimiter(FrameLimiter&) = delete;
+    FrameLimiter& operator=(FrameLimiter&) = delete;
+
+    // 0 turns the limiter off, the deadline grid restarts on the next wait
+    void set_target_fps(double fps);
+
+    double get_target_fps() const;
+
+    // blocks until the next frame deadline, returns right away when off or already late
+    void wait();
+
+    // how long the last wait blocked
+    double get_last_wait_ms() const;
+
+    // how far the last wait woke up from its deadline, late frames count as well
+    double get_last_jitter_ms() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // sleeps in short steps while the expected oversleep still fits, learning how long a step really takes
+    void sleep_until(Clock::time_point deadline);
+
+    double _target_fps = 0.0;
+    Clock::duration _period{};
+
+    Clock::time_point _next_deadline{};
+    bool _has_deadline = false;
+
+    double _last_wait_ms   = 0.0;
+    double _last_jitter_ms = 0.0;
+
+    // running mean and variance of a 1 ms sleep, starts pessimistic so the first frames spin more
+    double   _sleep_estimate_ms = 5.0;
+    double   _sleep_mean_ms     = 5.0;
+    double   _sleep_m2          = 0.0;
+    uint64_t _sleep_samples     = 1;
+};
+
+} // namespace fl
+
+#endif // _FL_FRAME_LIMITER_H
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef _FL_GPU_ALLOCATOR_H
+#define _FL_GPU_ALLOCATOR_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <mutex>
+#include <vector>
+
+namespace fl {
+
+// size of the device memory blocks resources get sub allocated from
+const VkDeviceSize DEFAULT_GPU_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+/// a sub range of a device memory block bound to a single buffer or image
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize   offset = 0;
+    VkDeviceSize   size   = 0;
+
+    // points at offset inside the persistently mapped block, null unless the memory is host visible
+    void *mapped_ptr = nullptr;
+
+    uint32_t mem_type  = 0;
+    uint32_t block_idx = 0;
+};
+
+struct GpuAllocatorStats {
+    uint32_t     block_count      = 0;
+    uint32_t     allocation_count = 0;
+    VkDeviceSize bytes_reserved   = 0; // device memory actually allocated from the driver
+    VkDeviceSize bytes_used       = 0; // bytes handed out to resources, excluding alignment padding
+};
+
+/// GpuAllocator hands out buffer and image memory from a few large blocks per memory type instead of calling
+/// vkAllocateMemory per resource, drivers limit the amount of allocations and each one is slow.
+/// Memory properties are cached once, allocations respect both alignment and bufferImageGranularity
+class GpuAllocator {
+public:
+    GpuAllocator();
+    ~GpuAllocator();
+
+    GpuAllocator(GpuAllocator&) = delete;
+    GpuAllocator& operator=(GpuAllocator&) = delete;
+
+    bool init(VkPhysicalDevice physical, VkDevice logical, VkDeviceSize block_size = DEFAULT_GPU_BLOCK_SIZE);
+
+    void destroy();
+
+    bool find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags props, uint32_t *mem_type_ptr) const;
+
+    // allocates memory for the resource and binds it
+    bool alloc_buffer(VkBuffer buffer, VkMemoryPropertyFlags props, GpuAllocation *alloc_ptr);
+    bool alloc_image(VkImage image, VkImageTiling tiling, VkMemoryPropertyFlags props, GpuAllocation *alloc_ptr);
+
+    // optimal tiling image memory left unbound, so several images can alias the same range
+    bool alloc_image_memory(const VkMemoryRequirements &reqs, VkMemoryPropertyFlags props, GpuAllocation *alloc_ptr);
+
+    void free(GpuAllocation *alloc_ptr);
+
+    const VkPhysicalDeviceMemoryProperties* get_mem_props_ptr() const;
+
+    void get_stats(GpuAllocatorStats *stats_ptr) const;
+    void log_stats() const;
+
+private:
+    // resources of different kinds sharing a bufferImageGranularity page may alias on some hardware
+    enum class ResourceKind {
+        FREE, LINEAR, OPTIMAL
+    };
+
+    struct Chunk {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        ResourceKind kind;
+    };
+
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize   size   = 0;
+        void *mapped_ptr = nullptr;
+
+        uint32_t mem_type = 0;
+        bool dedicated = false; // holds a single oversized resource, released once that is freed
+
+        VkDeviceSize used = 0;
+        uint32_t allocation_count = 0;
+
+        // covers the whole block ordered by offset, neighbouring free chunks are always merged
+        std::vector<Chunk> chunks{};
+    };
+
+    bool allocate(const VkMemoryRequirements &reqs, VkMemoryPropertyFlags props, ResourceKind kind,
+                  GpuAllocation *alloc_ptr);
+
+    bool create_block(uint32_t mem_type, VkDeviceSize size, bool dedicated, uint32_t *block_idx_ptr);
+
+    bool try_alloc_from_block(Block *block_ptr, VkDeviceSize size, VkDeviceSize alignment, ResourceKind kind,
+                              VkDeviceSize *offset_ptr);
+
+    bool is_kind_conflict(ResourceKind a, ResourceKind b) const;
+
+    std::vector<Block> _blocks{};
+
+    VkPhysicalDeviceMemoryProperties _mem_props{};
+
+    VkDeviceSize _block_size = DEFAULT_GPU_BLOCK_SIZE;
+    VkDeviceSize _buffer_image_granularity = 1;
+
+    mutable std::mutex _mutex;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_GPU_ALLOCATOR_H
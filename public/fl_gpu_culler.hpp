@@ -0,0 +1,121 @@
+#pragma once
+#ifndef _FL_GPU_CULLER_H
+#define _FL_GPU_CULLER_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+#include <fl_upload_service.hpp>
+#include <fl_shader_library.hpp>
+#include <fl_layout_cache.hpp>
+
+#include <vector>
+
+namespace fl {
+
+// the culler's own set, after the bindless heap and the uniform ring
+const uint32_t CULL_SET = 2;
+
+const uint32_t CULL_OBJECT_BINDING  = 0;
+const uint32_t CULL_COMMAND_BINDING = 1;
+const uint32_t CULL_COUNT_BINDING   = 2;
+
+// invocations per workgroup, matches local_size_x in cull.comp
+const uint32_t CULL_GROUP_SIZE = 64;
+
+const uint32_t DEFAULT_MAX_CULL_OBJECTS = 64 * 1024;
+
+/// 32 bytes, laid out like the std430 struct in cull.comp. The draw parameters refer to whatever index buffer
+/// is bound when the commands are drawn, so several meshes merged into one buffer cull in a single pass
+struct CullObject {
+    float center[3]     = { 0.0f, 0.0f, 0.0f };
+    float radius        = 0.0f; // bounding sphere around every instance of the object
+
+    uint32_t index_count    = 0;
+    uint32_t first_index    = 0;
+    int32_t  vertex_offset  = 0;
+    uint32_t instance_count = 1;
+};
+
+/// the planes a bounding sphere has to be in front of, a point p is inside when dot(xyz, p) + w >= 0
+struct CullView {
+    float planes[6][4]{};
+};
+
+// extracts the normalized frustum planes from a column major view projection matrix with a [0, 1] depth range
+void get_frustum_planes(const float *view_proj, CullView *view_ptr);
+
+/// GpuCuller keeps the bounds of every object in a device local storage buffer, a compute pass tests them against
+/// the view and writes a VkDrawIndexedIndirectCommand for each survivor. Recording the draws is a single indirect
+/// call however many objects there are, the commands and count are per frame in flight since frames overlap
+class GpuCuller {
+public:
+    GpuCuller();
+    ~GpuCuller();
+
+    GpuCuller(GpuCuller&) = delete;
+    GpuCuller& operator=(GpuCuller&) = delete;
+
+    // the compute shader comes from the library and its layout from the cache, draw_indirect_count and
+    // multi_draw_indirect are what the device enabled. Fails when cull.comp has not been compiled
+    bool init(VkDevice logical, GpuAllocator *allocator_ptr, UploadService *upload_service_ptr,
+              ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr, VkPipelineCache cache,
+              uint32_t frame_count, bool draw_indirect_count, bool multi_draw_indirect,
+              uint32_t max_objects = DEFAULT_MAX_CULL_OBJECTS);
+
+    void destroy();
+
+    // stages the objects for upload, frames recorded afterwards cull the new set
+    bool set_objects(const CullObject *objects, uint32_t count);
+
+    // records the culling dispatch and the barriers around it, has to happen outside of a render pass
+    void cull(VkCommandBuffer cmd_buf, size_t frame_idx, const CullView &view);
+
+    // draws whatever the frame's cull pass emitted, expects the pipeline and index buffer to be bound already
+    void draw(VkCommandBuffer cmd_buf, size_t frame_idx) const;
+
+    uint32_t get_object_count() const;
+
+private:
+    struct FrameCull {
+        VkBuffer      commands = VK_NULL_HANDLE;
+        GpuAllocation commands_alloc{};
+
+        VkBuffer      count = VK_NULL_HANDLE;
+        GpuAllocation count_alloc{};
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+    };
+
+    bool create_pipeline(ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr, VkPipelineCache cache);
+
+    // one set per frame in flight, pointing at the shared objects and the frame's commands and count
+    bool create_descriptor_sets();
+
+    std::vector<FrameCull> _frames{};
+
+    VkBuffer      _object_buf = VK_NULL_HANDLE;
+    GpuAllocation _object_alloc{};
+
+    uint32_t _max_objects  = 0;
+    uint32_t _object_count = 0;
+
+    VkPipeline       _pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout _layout   = VK_NULL_HANDLE; // owned by the layout cache, like the set layout
+
+    VkDescriptorSetLayout _set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool _pool     = VK_NULL_HANDLE;
+
+    bool _compact     = false; // survivors are packed and counted, drawn with the count read by the gpu
+    bool _multi_draw  = false;
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR _draw_indexed_indirect_count = nullptr;
+
+    GpuAllocator  *_allocator_ptr      = nullptr;
+    UploadService *_upload_service_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_GPU_CULLER_H
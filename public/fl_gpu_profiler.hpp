@@ -0,0 +1,95 @@
+#pragma once
+#ifndef _FL_GPU_PROFILER_H
+#define _FL_GPU_PROFILER_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <string>
+#include <vector>
+
+namespace fl {
+
+// maximum amount of profiled passes a single frame can record
+const uint32_t MAX_PROFILED_PASSES = 32;
+
+/// gpu cost of a single pass, the pipeline statistics tell vertex bound from fill bound passes
+struct GpuPassStats {
+    std::string name;
+    double gpu_ms = 0.0;
+
+    bool has_pipeline_stats = false;
+
+    uint64_t input_vertices       = 0;
+    uint64_t input_primitives     = 0;
+    uint64_t vertex_invocations   = 0;
+    uint64_t clipping_primitives  = 0;
+    uint64_t fragment_invocations = 0;
+};
+
+/// GpuProfiler measures how long the gpu spent on each frame and each pass within it using timestamp
+/// and optionally pipeline statistics queries. Every frame in flight owns its own range of queries,
+/// so results are read back without stalling once that frame's fence has signaled
+class GpuProfiler {
+public:
+    GpuProfiler();
+    ~GpuProfiler();
+
+    GpuProfiler(GpuProfiler&) = delete;
+    GpuProfiler& operator=(GpuProfiler&) = delete;
+
+    // pipeline statistics are only collected when requested and the device supports pipelineStatisticsQuery
+    bool init(VkPhysicalDevice physical, VkDevice logical, uint32_t queue_family_idx, uint32_t frame_count,
+              bool enable_pipeline_stats = false);
+
+    void destroy();
+
+    // false when the queue family cannot write timestamps, every other call then does nothing
+    bool is_supported() const;
+    bool has_pipeline_stats() const;
+
+    // statistics a secondary command buffer executed inside a profiled pass has to declare as inherited
+    VkQueryPipelineStatisticFlags get_pipeline_stats_flags() const;
+
+    // resets the frame's queries and writes the starting timestamp, record right after vkBeginCommandBuffer
+    void begin_frame(VkCommandBuffer cmd_buf, size_t frame_idx);
+    void end_frame(VkCommandBuffer cmd_buf, size_t frame_idx);
+
+    // wraps a pass, must be recorded outside of a render pass instance (around vkCmdBeginRenderPass)
+    void begin_pass(VkCommandBuffer cmd_buf, size_t frame_idx, const char *name);
+    void end_pass(VkCommandBuffer cmd_buf, size_t frame_idx);
+
+    // reads the results last recorded into this frame slot, only call after the frame's fence signaled.
+    // False once they were read, until end_frame records the slot again
+    bool read_frame(size_t frame_idx, double *gpu_ms_ptr, std::vector<GpuPassStats> *passes_ptr);
+
+private:
+    uint32_t first_timestamp_query(size_t frame_idx) const;
+    uint32_t first_stats_query(size_t frame_idx) const;
+
+    struct FrameSlot {
+        bool written = false; // unwritten queries have no results to read
+        bool in_pass = false;
+
+        std::vector<std::string> pass_names{};
+    };
+
+    VkQueryPool _timestamp_pool = VK_NULL_HANDLE;
+    VkQueryPool _stats_pool     = VK_NULL_HANDLE;
+
+    std::vector<FrameSlot> _frame_slots{};
+
+    // scratch space for reading results, kept around to avoid allocating every frame
+    std::vector<uint64_t> _timestamp_results{};
+    std::vector<uint64_t> _stats_results{};
+
+    float    _timestamp_period = 1.0f; // nanoseconds per tick
+    uint64_t _timestamp_mask   = 0;
+
+    bool _supported = false;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_GPU_PROFILER_H
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef _FL_LAYOUT_CACHE_H
+#define _FL_LAYOUT_CACHE_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_shader_reflection.hpp>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fl {
+
+/// a pipeline layout and the set layouts it was made from, everything is owned by the LayoutCache
+struct PipelineLayoutInfo {
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+
+    // indexed by set number, sets no stage uses get an empty layout
+    std::vector<VkDescriptorSetLayout> set_layouts{};
+};
+
+/// LayoutCache creates descriptor set layouts and pipeline layouts from shader reflection and hands out the same
+/// handle for every identical description. Pipelines with the same interface therefore share one layout, and
+/// descriptor sets bound for one stay bound when switching to the other. Safe to use from multiple threads
+class LayoutCache {
+public:
+    LayoutCache();
+    ~LayoutCache();
+
+    LayoutCache(LayoutCache&) = delete;
+    LayoutCache& operator=(LayoutCache&) = delete;
+
+    bool init(VkDevice logical);
+
+    // destroys every layout, pipelines created with them stay valid
+    void destroy();
+
+    // the bindings may be in any order, the returned layout is owned by the cache
+    bool get_set_layout(const std::vector<VkDescriptorSetLayoutBinding> &bindings, VkDescriptorSetLayout *layout_ptr);
+
+    bool get_pipeline_layout(const ShaderReflection &reflection, PipelineLayoutInfo *info_ptr);
+
+    // every pipeline layout created afterwards uses the given layout for this set, whatever the shaders declare.
+    // meant for global sets like the bindless heap, which stay bound across every pipeline switch
+    void reserve_set(uint32_t set, VkDescriptorSetLayout layout);
+
+    uint32_t get_set_layout_count() const;
+    uint32_t get_pipeline_layout_count() const;
+
+private:
+    // the exact description serialized, so equal keys always mean identical layouts
+    using LayoutKey = std::vector<uint64_t>;
+
+    struct LayoutKeyHasher {
+        size_t operator()(const LayoutKey &key) const;
+    };
+
+    std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHasher> _set_layouts{};
+    std::unordered_map<LayoutKey, PipelineLayoutInfo, LayoutKeyHasher> _pipeline_layouts{};
+
+    std::vector<VkDescriptorSetLayout> _reserved_sets{}; // indexed by set number, VK_NULL_HANDLE when not reserved
+
+    mutable std::mutex _mutex;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_LAYOUT_CACHE_H
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef _FL_MESH_H
+#define _FL_MESH_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+#include <fl_upload_service.hpp>
+
+#include <vector>
+
+namespace fl {
+
+/// Mesh owns indexed geometry in device local memory. Indices are stored as uint16 whenever every vertex
+/// can be addressed with them, which halves the index memory of all but the largest meshes
+class Mesh {
+public:
+    Mesh();
+    ~Mesh();
+
+    Mesh(Mesh&) = delete;
+    Mesh& operator=(Mesh&) = delete;
+
+    // only stages the data, the copies land with the next UploadService flush
+    bool init(VkDevice logical, GpuAllocator *allocator_ptr, UploadService *upload_ptr,
+              const void *vertices, uint32_t vertex_count, uint32_t vertex_stride,
+              const std::vector<uint32_t> &indices);
+
+    void destroy();
+
+    // binds the vertex buffer to binding 0 together with the index buffer
+    void bind(VkCommandBuffer cmd_buf) const;
+
+    uint32_t get_index_count() const;
+    uint32_t get_vertex_count() const;
+    VkIndexType get_index_type() const;
+
+private:
+    VkBuffer      _vertex_buf = VK_NULL_HANDLE;
+    GpuAllocation _vertex_alloc{};
+
+    VkBuffer      _index_buf = VK_NULL_HANDLE;
+    GpuAllocation _index_alloc{};
+
+    VkIndexType _index_type = VK_INDEX_TYPE_UINT16;
+
+    uint32_t _index_count  = 0;
+    uint32_t _vertex_count = 0;
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_MESH_H
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef _FL_MESH_BUILDER_H
+#define _FL_MESH_BUILDER_H
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace fl {
+
+// entries of the simulated post transform cache, large enough to model every desktop gpu reasonably
+const uint32_t VERTEX_CACHE_SIZE = 32;
+
+uint64_t hash_vertex_bytes(const void *data, size_t size);
+
+// reorders the triangles so that consecutive triangles share as many recently transformed vertices as possible,
+// using Tom Forsyth's linear speed vertex cache optimisation. The triangles themselves are left untouched
+void optimize_vertex_cache(uint32_t *indices, size_t index_count, size_t vertex_count);
+
+// average transformed vertices per triangle with a fifo cache of VERTEX_CACHE_SIZE entries, 0.5 is ideal, 3 is worst
+float get_acmr(const uint32_t *indices, size_t index_count, size_t vertex_count);
+
+/// MeshBuilder turns triangle soup into indexed geometry. Identical vertices are merged by hashing their bytes,
+/// so vertices must be value initialized to keep their padding, if any, from telling equal vertices apart
+template<typename VertexT>
+class MeshBuilder {
+public:
+    // returns the index of an identical vertex added before, or appends the vertex
+    uint32_t add_vertex(const VertexT &vertex) {
+        auto [found, inserted] = _lookup.emplace(vertex, static_cast<uint32_t>(_vertices.size()));
+
+        if(inserted)
+            _vertices.push_back(vertex);
+
+        return found->second;
+    }
+
+    void add_triangle(const VertexT &a, const VertexT &b, const VertexT &c) {
+        _indices.push_back(add_vertex(a));
+        _indices.push_back(add_vertex(b));
+        _indices.push_back(add_vertex(c));
+    }
+
+    // optimizing reorders the triangles for the vertex cache, then lays vertices out in the order they are first
+    // used so that vertex fetches walk through memory linearly
+    void build(std::vector<VertexT> *vertices_ptr, std::vector<uint32_t> *indices_ptr, bool optimize = true) const {
+        *indices_ptr = _indices;
+
+        if(optimize == false) {
+            *vertices_ptr = _vertices;
+            return;
+        }
+
+        optimize_vertex_cache(indices_ptr->data(), indices_ptr->size(), _vertices.size());
+
+        const uint32_t unused = UINT32_MAX;
+        std::vector<uint32_t> remap(_vertices.size(), unused);
+
+        vertices_ptr->clear();
+        vertices_ptr->reserve(_vertices.size());
+
+        for(uint32_t &index : *indices_ptr) {
+            if(remap[index] == unused) {
+                remap[index] = static_cast<uint32_t>(vertices_ptr->size());
+                vertices_ptr->push_back(_vertices[index]);
+            }
+
+            index = remap[index];
+        }
+    }
+
+    void clear() {
+        _lookup.clear();
+        _vertices.clear();
+        _indices.clear();
+    }
+
+    uint32_t get_vertex_count() const {
+        return static_cast<uint32_t>(_vertices.size());
+    }
+
+    uint32_t get_index_count() const {
+        return static_cast<uint32_t>(_indices.size());
+    }
+
+private:
+    struct BytesHasher {
+        size_t operator()(const VertexT &vertex) const {
+            return static_cast<size_t>(hash_vertex_bytes(&vertex, sizeof(VertexT)));
+        }
+    };
+
+    struct BytesEqual {
+        bool operator()(const VertexT &a, const VertexT &b) const {
+            return memcmp(&a, &b, sizeof(VertexT)) == 0;
+        }
+    };
+
+    std::unordered_map<VertexT, uint32_t, BytesHasher, BytesEqual> _lookup{};
+
+    std::vector<VertexT>  _vertices{};
+    std::vector<uint32_t> _indices{};
+};
+
+} // namespace fl
+
+#endif // _FL_MESH_BUILDER_H
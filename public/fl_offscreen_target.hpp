@@ -0,0 +1,48 @@
+#pragma once
+#ifndef _FL_OFFSCREEN_TARGET_H
+#define _FL_OFFSCREEN_TARGET_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+
+#include <vector>
+
+namespace fl {
+
+/// OffscreenTarget is the headless counterpart of the Swapchain, it owns a set of device local images
+/// that can be rendered into without any surface or presentation engine
+class OffscreenTarget {
+public:
+    OffscreenTarget();
+    ~OffscreenTarget();
+
+    OffscreenTarget(OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(OffscreenTarget&) = delete;
+
+    bool init(VkDevice device, GpuAllocator *allocator_ptr,
+              VkFormat format, VkExtent2D extent, uint32_t img_count);
+
+    void destroy();
+
+    VkFormat get_img_format() const;
+    VkExtent2D get_img_extent() const;
+
+    uint32_t get_images(std::vector<VkImage> *images_ptr);
+
+private:
+    bool create_image(VkImage *img_ptr, GpuAllocation *alloc_ptr);
+
+    std::vector<VkImage>       _imgs{};
+    std::vector<GpuAllocation> _img_allocs{};
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+
+    VkFormat   _img_fmt;
+    VkExtent2D _img_extent;
+};
+
+} // namespace fl
+
+#endif // _FL_OFFSCREEN_TARGET_H
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef _FL_OPAQUE_QUEUE_H
+#define _FL_OPAQUE_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace fl {
+
+/// a single indexed draw of opaque geometry
+struct OpaqueDraw {
+    float    depth = 0.0f; // where the draw lands in the depth buffer, 0 is nearest
+    uint32_t index_count    = 0;
+    uint32_t instance_count = 1;
+};
+
+/// OpaqueQueue collects the opaque draws and sorts them front to back. With a depth buffer the nearest layers
+/// then fill it first, and fragments of the layers behind them fail the depth test before they are shaded
+class OpaqueQueue {
+public:
+    OpaqueQueue();
+
+    OpaqueQueue(OpaqueQueue&) = delete;
+    OpaqueQueue& operator=(OpaqueQueue&) = delete;
+
+    void clear();
+
+    void push(const OpaqueDraw &draw);
+
+    // draws at the same depth keep the order they were pushed in
+    void sort_front_to_back();
+
+    uint32_t get_count() const;
+
+    const OpaqueDraw* get_draws_ptr() const;
+
+private:
+    std::vector<OpaqueDraw> _draws{};
+};
+
+} // namespace fl
+
+#endif // _FL_OPAQUE_QUEUE_H
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef _FL_PARALLEL_RECORDER_H
+#define _FL_PARALLEL_RECORDER_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_thread_pool.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace fl {
+
+// fewer items than this per task cost more in scheduling than they save in recording
+const uint32_t MIN_RECORD_ITEMS_PER_TASK = 64;
+
+// records the items [first, first + count) into the given secondary command buffer, runs on any thread
+using RecordRangeFunc = std::function<void(VkCommandBuffer cmd_buf, uint32_t first, uint32_t count)>;
+
+/// ParallelRecorder splits recording work across the ThreadPool, every task records into a secondary command buffer
+/// from its own command pool. Pools are per task slot and per frame in flight, so no pool is ever touched by
+/// two threads at once and a whole frame's worth of buffers is recycled with a single vkResetCommandPool
+class ParallelRecorder {
+public:
+    ParallelRecorder();
+    ~ParallelRecorder();
+
+    ParallelRecorder(ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(ParallelRecorder&) = delete;
+
+    bool init(VkDevice logical, uint32_t queue_family_idx, ThreadPool *pool_ptr, uint32_t frame_count);
+
+    void destroy();
+
+    // recycles every secondary recorded for this frame slot, only call after the frame's fence signaled
+    void begin_frame(size_t frame_idx);
+
+    // records item_count items split into ranges, the calling thread records one range itself.
+    // secondaries are returned in range order, ready for vkCmdExecuteCommands
+    bool record(size_t frame_idx, const VkCommandBufferInheritanceInfo &inheritance, uint32_t item_count,
+                const RecordRangeFunc &record_func, std::vector<VkCommandBuffer> *secondaries_ptr);
+
+    // the most ranges a single record call splits into
+    uint32_t get_max_task_count() const;
+
+private:
+    struct TaskSlot {
+        VkCommandPool pool = VK_NULL_HANDLE;
+
+        // allocated on demand and kept across frames, only the pool is reset
+        std::vector<VkCommandBuffer> cmd_bufs{};
+        uint32_t used = 0;
+    };
+
+    bool acquire_cmd_buf(TaskSlot *slot_ptr, VkCommandBuffer *cmd_buf_ptr);
+
+    std::vector<TaskSlot> _slots{}; // frame major, _max_task_count slots per frame
+
+    uint32_t _max_task_count = 1; // every worker plus the calling thread
+
+    ThreadPool *_pool_ptr = nullptr;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_PARALLEL_RECORDER_H
@@ -6,6 +6,9 @@
 #include <glm/glm.hpp>
 
 #include <fl_swapchain.hpp>
+#include <fl_shader_library.hpp>
+#include <fl_layout_cache.hpp>
+#include <fl_vertex_layout.hpp>
 
 #include <string>
 #include <vector>
@@ -22,63 +25,64 @@ namespace fl {
 // 5. Color Blending
 // <- Frame Buffer(Img)
 
+/// 8 bytes, half float position and an R8G8B8A8 color, down from two float vectors in 20 bytes
 struct Vertex {
-    glm::vec2 pos; 
-    glm::vec3 color;
+    Half2    pos;
+    Unorm8x4 color;
 
-    // TODO: move this in an implementation file
-    // this vertex binding describes at which rate to load data from memory
-    // throughout the vertices. It specifies the number of bytes between data entries
-    // and whether to move the next data entry after each vertex or after each instance. (vulkan-tutorial)
-    static VkVertexInputBindingDescription get_binding_desc() {
-        VkVertexInputBindingDescription desc{};
-
-        desc.binding = 0;
-        desc.stride = sizeof(Vertex);
-
-        desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // send information per vertex
-
-        return desc;
-    }
-
-    static std::array<VkVertexInputAttributeDescription, 2> get_attr_descs() {
-        std::array<VkVertexInputAttributeDescription, 2> descs{};
-
-        descs[0].binding  = 0;
-        descs[0].location = 0;
-        descs[0].format = VK_FORMAT_R32G32_SFLOAT;
-        descs[0].offset = offsetof(Vertex, pos);
+    // bindings and attributes derived from DefaultVertexLayout below
+    static VertexInputDesc get_input_desc();
+};
 
-        descs[1].binding  = 0;
-        descs[1].location = 1;
-        descs[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        descs[1].offset = offsetof(Vertex, color);
+// the vertex has to be complete for offsetof, so the layout lives outside of it
+using DefaultVertexLayout = VertexLayout<Vertex, FL_VERTEX_ATTR(Vertex, pos), FL_VERTEX_ATTR(Vertex, color)>;
 
-        return descs;
-    }
-};
+inline VertexInputDesc Vertex::get_input_desc() {
+    return DefaultVertexLayout::get_input_desc();
+}
 
 
 class Pipeline {
 public:
-    Pipeline(const std::string &vert_path, const std::string &frag_path);
+    Pipeline(const std::string &vert_path, const std::string &frag_path,
+             const VertexInputDesc &vertex_input = Vertex::get_input_desc());
     ~Pipeline();
 
     Pipeline(Pipeline&) = delete;
     Pipeline& operator=(Pipeline&) = delete;
 
-    bool init(VkDevice logical, Swapchain *swap_chain_ptr, VkRenderPass render_pass,
-                    VkViewport *p_viewport, VkRect2D *p_scissor);
+    // shader modules come from the library and the layout from the layout cache, both are shared with other
+    // pipelines. The cache is optional, pass VK_NULL_HANDLE to always compile from scratch. Without a render pass
+    // the pipeline is built for dynamic rendering into a single color attachment of color_format.
+    // VK_FORMAT_UNDEFINED as depth_format means the pass has no depth attachment, depth_test is ignored then
+    bool init(VkDevice logical, Swapchain *swap_chain_ptr, VkRenderPass render_pass, VkFormat color_format,
+                    VkFormat depth_format, bool depth_test, VkViewport *p_viewport, VkRect2D *p_scissor,
+                    ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr,
+                    VkPipelineCache cache = VK_NULL_HANDLE);
 
     VkPipeline get_raw_graphics_handle() const;
+    VkPipelineLayout get_raw_layout_handle() const;
+
+    // VK_NULL_HANDLE for sets the shaders do not declare
+    VkDescriptorSetLayout get_raw_set_layout_handle(uint32_t set) const;
+
+    // the merged interface of every stage
+    const ShaderReflection& get_reflection() const;
 
 private:
     // creates a graphics pipeline
-    bool create_graphics(VkRenderPass render_pass,
+    bool create_graphics(VkRenderPass render_pass, VkFormat color_format, VkFormat depth_format, bool depth_test,
+                         VkPipelineCache cache,
+                         ShaderLibrary *shader_library_ptr,
                          const std::string &vert_path, const std::string &frag_path);
-    bool create_shader_module(const std::vector<char> *shader_code_ptr, VkShaderModule *module_ptr);
     bool create_render_pass();
 
+    // reflects both stages and gets the matching layout from the cache
+    bool create_layout(ShaderLibrary *shader_library_ptr, LayoutCache *layout_cache_ptr);
+
+    // warns about vertex shader inputs no attribute feeds
+    void check_vertex_inputs() const;
+
     std::vector<VkDynamicState> _dynamic_states = {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR
@@ -87,11 +91,16 @@ private:
     const std::string _vert_path;
     const std::string _frag_path;
 
+    const VertexInputDesc _vertex_input;
+
 
     Swapchain *_swap_chain_ptr = nullptr;
 
-    // layout of the uniformed values passed into the vertex and fragment shaders
+    // layout of the uniformed values passed into the vertex and fragment shaders, owned by the layout cache
     VkPipelineLayout _layout = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSetLayout> _set_layouts{};
+
+    ShaderReflection _reflection{};
 
     VkPipeline _graphics = VK_NULL_HANDLE;
 
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef _FL_PIPELINE_BUILDER_H
+#define _FL_PIPELINE_BUILDER_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_pipeline.hpp>
+#include <fl_thread_pool.hpp>
+
+#include <future>
+#include <vector>
+
+namespace fl {
+
+/// everything Pipeline::init needs, the pointed to objects must outlive the build
+struct PipelineBuildInfo {
+    Pipeline *pipeline_ptr = nullptr;
+
+    Swapchain   *swap_chain_ptr = nullptr;
+    VkRenderPass render_pass    = VK_NULL_HANDLE;
+    VkFormat     color_format   = VK_FORMAT_UNDEFINED; // only read without a render pass, for dynamic rendering
+    VkFormat     depth_format   = VK_FORMAT_UNDEFINED; // the pass has no depth attachment when undefined
+    bool         depth_test     = false;               // opaque pipelines test and write depth, overlays do neither
+
+    VkViewport *viewport_ptr = nullptr;
+    VkRect2D   *scissor_ptr  = nullptr;
+};
+
+/// PipelineBuilder compiles pipelines on a ThreadPool, shader loading and vkCreateGraphicsPipelines of different
+/// pipelines run concurrently. Every build shares the same ShaderLibrary, LayoutCache and VkPipelineCache,
+/// which are all synchronized internally
+class PipelineBuilder {
+public:
+    PipelineBuilder();
+    ~PipelineBuilder();
+
+    PipelineBuilder(PipelineBuilder&) = delete;
+    PipelineBuilder& operator=(PipelineBuilder&) = delete;
+
+    // the cache may be VK_NULL_HANDLE, it must not be created with VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT
+    bool init(VkDevice logical, ThreadPool *pool_ptr, ShaderLibrary *shader_library_ptr,
+              LayoutCache *layout_cache_ptr, VkPipelineCache cache = VK_NULL_HANDLE);
+
+    // starts compiling on a worker right away, the future tells whether Pipeline::init succeeded
+    std::shared_future<bool> build(const PipelineBuildInfo &info);
+
+    void build_all(const std::vector<PipelineBuildInfo> &infos, std::vector<std::shared_future<bool>> *results_ptr);
+
+    // blocks until every pipeline built so far finished, false when any of them failed
+    bool wait_all();
+
+private:
+    std::vector<std::shared_future<bool>> _pending{};
+
+    ThreadPool    *_pool_ptr = nullptr;
+    ShaderLibrary *_shader_library_ptr = nullptr;
+    LayoutCache   *_layout_cache_ptr = nullptr;
+
+    VkPipelineCache _cache = VK_NULL_HANDLE;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_PIPELINE_BUILDER_H
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef _FL_PIPELINE_CACHE_H
+#define _FL_PIPELINE_CACHE_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <string>
+#include <vector>
+
+namespace fl {
+
+// relative to the working directory, next to the compiled shaders
+const char* const DEFAULT_PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
+/// PipelineCache keeps a VkPipelineCache alive across launches by loading it from and saving it to disk,
+/// so pipelines only compile from scratch the first time they are seen on a given device and driver.
+/// Files written by another device or driver version are rejected by their header and start the cache empty
+class PipelineCache {
+public:
+    PipelineCache();
+    ~PipelineCache();
+
+    PipelineCache(PipelineCache&) = delete;
+    PipelineCache& operator=(PipelineCache&) = delete;
+
+    // a missing or mismatching file is not an error, the cache simply starts out empty
+    bool init(VkPhysicalDevice physical, VkDevice logical, const std::string &path = DEFAULT_PIPELINE_CACHE_PATH);
+
+    // saves before destroying the cache
+    void destroy();
+
+    // writes into a temporary file which then replaces the old one, so a crash never leaves a torn file behind.
+    // does nothing when the cache did not change since it was loaded or last saved
+    bool save();
+
+    VkPipelineCache get_raw_handle() const;
+
+private:
+    bool is_header_compatible(const std::vector<uint8_t> &data) const;
+
+    VkPipelineCache _cache = VK_NULL_HANDLE;
+
+    std::string _path;
+
+    // contents currently on disk, used to skip rewriting an unchanged cache
+    std::vector<uint8_t> _disk_data{};
+
+    VkPhysicalDeviceProperties _device_props{};
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_PIPELINE_CACHE_H
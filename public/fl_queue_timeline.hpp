@@ -0,0 +1,61 @@
+#pragma once
+#ifndef _FL_QUEUE_TIMELINE_H
+#define _FL_QUEUE_TIMELINE_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+
+namespace fl {
+
+/// QueueTimeline wraps a single timeline semaphore that every submit to one queue signals with the next value.
+/// Waiting for a frame becomes waiting for the value its submit signaled, and checking whether resources a
+/// submit used are free again is a comparison against the completed value. Needs DeviceFeatures::timeline_semaphore
+class QueueTimeline {
+public:
+    QueueTimeline();
+    ~QueueTimeline();
+
+    QueueTimeline(QueueTimeline&) = delete;
+    QueueTimeline& operator=(QueueTimeline&) = delete;
+
+    bool init(VkDevice logical);
+
+    void destroy();
+
+    // the value the next submit signals. Only commit_value makes it the last value, so a submit that fails
+    // leaves nothing waiting on a value that is never signaled
+    uint64_t get_pending_value() const;
+
+    // call once the submit signaling the pending value succeeded
+    void commit_value();
+
+    // the last committed value, 0 before the first submit
+    uint64_t get_last_value() const;
+
+    // the value the gpu has reached, every submit signaling up to it has completed
+    uint64_t get_completed_value();
+
+    bool is_complete(uint64_t value);
+
+    // blocks until the value is reached, true right away for 0
+    bool wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+    VkSemaphore get_raw_handle() const;
+
+private:
+    VkSemaphore _semaphore = VK_NULL_HANDLE;
+
+    uint64_t _last_value      = 0;
+    uint64_t _completed_value = 0; // cached, so repeated checks against older values skip the driver call
+
+    // core entry points from 1.2 on, the KHR ones on top of 1.1
+    PFN_vkWaitSemaphoresKHR            _wait_semaphores   = nullptr;
+    PFN_vkGetSemaphoreCounterValueKHR  _get_counter_value = nullptr;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_QUEUE_TIMELINE_H
@@ -0,0 +1,214 @@
+#pragma once
+#ifndef _FL_RENDER_GRAPH_H
+#define _FL_RENDER_GRAPH_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+#include <fl_deletion_queue.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fl {
+
+using RenderResourceId = uint32_t;
+using RenderPassId     = uint32_t;
+
+const uint32_t INVALID_RENDER_ID = UINT32_MAX;
+
+/// how a pass uses an image, each maps to the stages, access and layout the barriers are computed from
+enum class ImageAccess {
+    COLOR_ATTACHMENT,
+    DEPTH_ATTACHMENT,
+    DEPTH_READ,      // depth test without writes
+    SAMPLED,         // read in the fragment or compute shader
+    STORAGE_READ,
+    STORAGE_WRITE,
+    TRANSFER_SRC,
+    TRANSFER_DST
+};
+
+/// where an imported image is before the graph runs, or where it has to be once it finished
+struct ImageState {
+    VkImageLayout        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkAccessFlags        access = 0;
+};
+
+/// an image the graph creates and owns, only valid while the passes using it run
+struct TransientImageDesc {
+    VkFormat   format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+};
+
+struct RenderGraphStats {
+    uint32_t pass_count        = 0;
+    uint32_t culled_pass_count = 0;
+    uint32_t barrier_count     = 0; // vkCmdPipelineBarrier calls per execute, each batches every image of a pass
+    uint32_t transient_count   = 0;
+    uint32_t lazy_count        = 0; // transients backed by lazily allocated memory, tilers may never commit it
+
+    VkDeviceSize transient_bytes = 0; // what every transient would take on its own
+    VkDeviceSize allocated_bytes = 0; // what they take with lifetimes that do not overlap sharing memory
+};
+
+// records a pass, false stops the execute
+using RecordPassFunc = std::function<bool(VkCommandBuffer)>;
+
+/// RenderGraph orders the frame as passes that declare which images they read and write.
+/// compile() culls passes nothing consumes, precomputes the barriers and layout transitions between the
+/// declared uses, and places transient images whose pass ranges do not overlap in the same memory.
+/// Passes run in the order they were added, execute() only replays the precomputed barriers around them.
+/// Attachments a single pass uses are created as transient attachments, their contents never leave that pass.
+/// Only images are tracked, passes synchronize buffers they share themselves
+class RenderGraph {
+public:
+    RenderGraph();
+    ~RenderGraph();
+
+    RenderGraph(RenderGraph&) = delete;
+    RenderGraph& operator=(RenderGraph&) = delete;
+
+    bool init(VkDevice logical, GpuAllocator *allocator_ptr);
+
+    // the device must be idle, or frames using the transients finished
+    void destroy();
+
+    // drops every pass and resource declared, the transient images stay until the next compile replaces them
+    void clear();
+
+    // an image owned elsewhere, like the swap chain image. A final state makes it an output of the graph, keeping
+    // the passes writing it alive and transitioning it once the last of them ran
+    RenderResourceId import_image(const std::string &name, VkImageAspectFlags aspect, const ImageState &initial,
+                                  const ImageState *final_ptr = nullptr);
+
+    // the image behind an import can change every frame, has to be set before execute
+    void set_imported_image(RenderResourceId resource, VkImage img, VkImageView view);
+
+    RenderResourceId create_image(const std::string &name, const TransientImageDesc &desc);
+
+    RenderPassId add_pass(const std::string &name, RecordPassFunc &&record_func);
+
+    void read(RenderPassId pass, RenderResourceId resource, ImageAccess access);
+    void write(RenderPassId pass, RenderResourceId resource, ImageAccess access);
+
+    // the pass does work the graph cannot see, like writing buffers, and is never culled
+    void set_side_effects(RenderPassId pass);
+
+    // the transients of the previous compile are retired through the deletion queue when there is one, and
+    // destroyed right away otherwise
+    bool compile(DeletionQueue *deletion_queue_ptr = nullptr);
+
+    bool execute(VkCommandBuffer cmd_buf);
+
+    VkImage get_image(RenderResourceId resource) const;
+    VkImageView get_view(RenderResourceId resource) const;
+
+    // false when the pass was culled by the last compile
+    bool is_pass_active(RenderPassId pass) const;
+
+    const RenderGraphStats* get_stats_ptr() const;
+
+private:
+    struct ImageUse {
+        RenderResourceId resource;
+        ImageAccess      access;
+        bool             write;
+    };
+
+    struct Pass {
+        std::string name;
+        RecordPassFunc record_func;
+
+        std::vector<ImageUse> uses{};
+        bool side_effects = false;
+        bool active       = false;
+    };
+
+    struct Resource {
+        std::string name;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+        bool imported = false;
+        ImageState initial{};
+        ImageState final{};
+        bool has_final = false;
+
+        TransientImageDesc desc{};
+        VkImageUsageFlags usage = 0;
+        uint32_t alias_slot = INVALID_RENDER_ID;
+
+        VkImage     img  = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
+    struct Barrier {
+        RenderResourceId resource;
+        VkImageLayout old_layout;
+        VkImageLayout new_layout;
+        VkAccessFlags src_access;
+        VkAccessFlags dst_access;
+    };
+
+    // every image barrier recorded before one pass, or after the last one
+    struct BarrierBatch {
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+        std::vector<Barrier> barriers{};
+    };
+
+    // transients sharing one memory range, none of their pass ranges overlap
+    struct AliasSlot {
+        VkMemoryRequirements reqs{};
+        VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        GpuAllocation alloc{};
+        std::vector<RenderResourceId> resources{};
+        std::vector<uint32_t> first_uses{}, last_uses{}; // pass ranges in execution order, one per resource
+    };
+
+    // what the barriers after a use have to wait for, tracked per image or, for transients, per alias slot
+    struct SyncState {
+        VkPipelineStageFlags write_stages   = 0;
+        VkAccessFlags        write_access   = 0;
+        VkPipelineStageFlags read_stages    = 0; // every stage reading since the last write
+        VkPipelineStageFlags visible_stages = 0; // stages and access the last write was made visible to
+        VkAccessFlags        visible_access = 0;
+    };
+
+    void cull_passes();
+
+    bool create_transients();
+
+    void assign_alias_slots(const std::vector<uint32_t> &first_uses, const std::vector<uint32_t> &last_uses);
+
+    bool compute_barriers();
+
+    void release_transients(DeletionQueue *deletion_queue_ptr);
+
+    void record_batch(VkCommandBuffer cmd_buf, const BarrierBatch &batch) const;
+
+    std::vector<Pass>     _passes{};
+    std::vector<Resource> _resources{};
+
+    std::vector<RenderPassId> _exec_order{}; // active passes only
+    std::vector<BarrierBatch> _pass_barriers{}; // one per entry of _exec_order
+    BarrierBatch _final_barriers{};
+
+    std::vector<AliasSlot> _alias_slots{};
+
+    // images and memory of the last compile, kept apart from _resources so clear() does not leak them
+    std::vector<VkImage>       _transient_imgs{};
+    std::vector<VkImageView>   _transient_views{};
+    std::vector<GpuAllocation> _transient_allocs{};
+
+    RenderGraphStats _stats{};
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_RENDER_GRAPH_H
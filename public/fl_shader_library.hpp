@@ -0,0 +1,70 @@
+#pragma once
+#ifndef _FL_SHADER_LIBRARY_H
+#define _FL_SHADER_LIBRARY_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_shader_reflection.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace fl {
+
+/// ShaderLibrary owns every VkShaderModule, SPIR-V files are memory mapped and hashed so pipelines
+/// using the same binary, even under different paths, share a single module. Every module is reflected
+/// once while it is still mapped. Safe to use from multiple threads
+class ShaderLibrary {
+public:
+    ShaderLibrary();
+    ~ShaderLibrary();
+
+    ShaderLibrary(ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(ShaderLibrary&) = delete;
+
+    bool init(VkDevice logical);
+
+    // destroys every module, pipelines created from them stay valid
+    void destroy();
+
+    // the returned module is owned by the library, never destroy it yourself.
+    // the reflection is optional and describes the interface of the module
+    bool get_module(const std::string &path, VkShaderModule *module_ptr, ShaderReflection *reflection_ptr = nullptr);
+
+    uint32_t get_module_count() const;
+
+private:
+    struct ShaderKey {
+        uint64_t hash;
+        size_t   size;
+
+        bool operator==(const ShaderKey &other) const {
+            return hash == other.hash && size == other.size;
+        }
+    };
+
+    struct ShaderKeyHasher {
+        size_t operator()(const ShaderKey &key) const {
+            return static_cast<size_t>(key.hash ^ (key.size * 0x9e3779b97f4a7c15ull));
+        }
+    };
+
+    struct LoadedShader {
+        VkShaderModule   module = VK_NULL_HANDLE;
+        ShaderReflection reflection{};
+    };
+
+    static void copy_loaded(const LoadedShader &loaded, VkShaderModule *module_ptr, ShaderReflection *reflection_ptr);
+
+    std::unordered_map<std::string, LoadedShader> _path_modules{};
+    std::unordered_map<ShaderKey, LoadedShader, ShaderKeyHasher> _modules{};
+
+    mutable std::mutex _mutex;
+
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_SHADER_LIBRARY_H
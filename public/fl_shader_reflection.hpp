@@ -0,0 +1,51 @@
+#pragma once
+#ifndef _FL_SHADER_REFLECTION_H
+#define _FL_SHADER_REFLECTION_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fl {
+
+/// a descriptor the shader declares, bindings of several stages are merged by set and binding
+struct ReflectedBinding {
+    uint32_t set     = 0;
+    uint32_t binding = 0;
+
+    VkDescriptorType   type   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uint32_t           count  = 1;
+    VkShaderStageFlags stages = 0;
+
+    bool unsized = false; // a runtime array, the count is only known once descriptors are written
+};
+
+/// a vertex shader input, built-ins are skipped
+struct ReflectedInput {
+    uint32_t location = 0;
+    VkFormat format   = VK_FORMAT_UNDEFINED;
+};
+
+/// everything a pipeline layout needs from one or more shader stages
+struct ShaderReflection {
+    VkShaderStageFlags stages = 0;
+
+    std::vector<ReflectedBinding> bindings{}; // sorted by set, then binding
+
+    // a size of 0 means the stages use no push constants
+    VkPushConstantRange push_constants{};
+
+    std::vector<ReflectedInput> inputs{}; // vertex stage only, sorted by location
+};
+
+// parses the SPIR-V module of a single stage, fails on malformed code
+bool reflect_shader(const uint32_t *words, size_t size, ShaderReflection *res_ptr);
+
+// folds another stage into the merged reflection, fails when both declare the same binding differently
+bool merge_shader_reflection(const ShaderReflection &stage, ShaderReflection *merged_ptr);
+
+} // namespace fl
+
+#endif // _FL_SHADER_REFLECTION_H
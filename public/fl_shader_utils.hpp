@@ -4,11 +4,27 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 namespace fl {
 
 bool read_compiled_shader(const std::string &path, std::vector<char> *res_ptr);
 
+/// a read only memory mapping of a compiled SPIR-V file, the words are page aligned and valid until unmapped
+struct MappedShader {
+    const uint32_t *words = nullptr;
+    size_t size = 0; // in bytes
+
+    void *map_handle = nullptr; // platform specific, only used to unmap
+};
+
+// fails when the file cannot be mapped or is not SPIR-V
+bool map_compiled_shader(const std::string &path, MappedShader *res_ptr);
+void unmap_compiled_shader(MappedShader *shader_ptr);
+
+// 64 bit FNV-1a over the whole binary
+uint64_t hash_shader_code(const uint32_t *words, size_t size);
+
 } // namespace fl
 
 #endif // _FL_SHADER_UTILS_H
@@ -0,0 +1,107 @@
+#pragma once
+#ifndef _FL_SPRITE_BATCHER_H
+#define _FL_SPRITE_BATCHER_H
+
+#include <vulkan/vulkan_core.h>
+#include <glm/glm.hpp>
+
+#include <fl_gpu_allocator.hpp>
+#include <fl_pipeline.hpp>
+#include <fl_bindless_heap.hpp>
+
+#include <vector>
+
+namespace fl {
+
+// sprites a single frame can queue before draw starts failing
+const uint32_t DEFAULT_MAX_SPRITES_PER_FRAME = 64 * 1024;
+
+/// per instance data of a single quad, read by vendor/shaders/sprite.vert
+struct SpriteInstance {
+    glm::vec2 center;    // device coordinates
+    glm::vec2 half_size;
+    glm::vec4 uv_rect  = { 0.0f, 0.0f, 1.0f, 1.0f }; // min uv in xy, max uv in zw
+    uint32_t  color    = 0xffffffff; // R8G8B8A8, red in the lowest byte
+    float     rotation = 0.0f;       // radians
+
+    uint32_t texture_idx = INVALID_BINDLESS_IDX; // slot in the bindless heap, untextured when invalid
+};
+
+/// what a sprite is drawn with, consecutive sprites with the same material end up in the same draw
+struct SpriteMaterial {
+    VkPipeline       pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout   = VK_NULL_HANDLE;
+
+    // textures are picked per sprite through the bindless heap, they never split a batch
+    bool operator==(const SpriteMaterial &other) const {
+        return pipeline == other.pipeline;
+    }
+};
+
+/// SpriteBatcher writes sprites straight into a persistently mapped instance buffer and draws them with one
+/// instanced draw per batch, a batch only breaks when the pipeline changes. Every frame in flight
+/// owns its own region of the buffer, so writing a frame never waits on the gpu reading an older one
+class SpriteBatcher {
+public:
+    SpriteBatcher();
+    ~SpriteBatcher();
+
+    SpriteBatcher(SpriteBatcher&) = delete;
+    SpriteBatcher& operator=(SpriteBatcher&) = delete;
+
+    // without a bindless heap every sprite is drawn untextured
+    bool init(VkDevice logical, GpuAllocator *allocator_ptr, uint32_t frame_count,
+              const BindlessHeap *heap_ptr = nullptr,
+              uint32_t max_sprites_per_frame = DEFAULT_MAX_SPRITES_PER_FRAME);
+
+    void destroy();
+
+    // instance rate vertex input matching SpriteInstance, for pipelines drawing sprites
+    static VertexInputDesc get_input_desc();
+
+    // starts writing into the frame's region, only call after the frame's fence signaled
+    void begin_frame(size_t frame_idx);
+
+    // false once the frame's region is full, the sprites that did not fit are dropped
+    bool draw(const SpriteMaterial &material, const SpriteInstance &sprite);
+    bool draw(const SpriteMaterial &material, const SpriteInstance *sprites, uint32_t count);
+
+    // records the batches queued since the last flush, viewport and scissor must already be set
+    void flush(VkCommandBuffer cmd_buf);
+
+    bool has_pending() const;
+
+    uint32_t get_sprite_count() const; // sprites written this frame
+    uint32_t get_batch_count() const;  // draws recorded this frame
+
+private:
+    struct Batch {
+        SpriteMaterial material;
+
+        uint32_t first_instance;
+        uint32_t instance_count;
+    };
+
+    SpriteInstance* reserve(const SpriteMaterial &material, uint32_t count);
+
+    std::vector<Batch> _batches{};
+
+    VkBuffer      _instance_buf = VK_NULL_HANDLE;
+    GpuAllocation _instance_alloc{};
+
+    SpriteInstance *_frame_sprites = nullptr; // start of the current frame's region in mapped memory
+    VkDeviceSize    _frame_offset  = 0;
+
+    uint32_t _max_sprites_per_frame = 0;
+    uint32_t _sprite_count = 0;
+    uint32_t _batch_count  = 0;
+
+    const BindlessHeap *_heap_ptr = nullptr;
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_SPRITE_BATCHER_H
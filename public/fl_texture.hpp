@@ -0,0 +1,44 @@
+#pragma once
+#ifndef _FL_TEXTURE_H
+#define _FL_TEXTURE_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+#include <fl_upload_service.hpp>
+
+namespace fl {
+
+/// Texture owns a sampled 2d image in device local memory together with its view, single mip level only
+class Texture {
+public:
+    Texture();
+    ~Texture();
+
+    Texture(Texture&) = delete;
+    Texture& operator=(Texture&) = delete;
+
+    // the texels are tightly packed 4 byte pixels, the copy lands with the next UploadService flush
+    bool init(VkDevice logical, GpuAllocator *allocator_ptr, UploadService *upload_ptr,
+              VkExtent2D extent, const void *pixels, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
+
+    void destroy();
+
+    VkImage get_raw_handle() const;
+    VkImageView get_raw_view_handle() const;
+    VkExtent2D get_extent() const;
+
+private:
+    VkImage       _img = VK_NULL_HANDLE;
+    VkImageView   _view = VK_NULL_HANDLE;
+    GpuAllocation _alloc{};
+
+    VkExtent2D _extent{};
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_TEXTURE_H
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef _FL_THREAD_POOL_H
+#define _FL_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fl {
+
+/// ThreadPool runs submitted jobs on a fixed set of worker threads, jobs are picked up in submission order
+class ThreadPool {
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&) = delete;
+
+    // a thread count of 0 uses one worker per hardware thread
+    bool init(uint32_t thread_count = 0);
+
+    // finishes every job already submitted, then joins the workers
+    void destroy();
+
+    uint32_t get_thread_count() const;
+
+    template<typename Func>
+    auto submit(Func &&func) -> std::future<std::invoke_result_t<Func>> {
+        using Result = std::invoke_result_t<Func>;
+
+        // std::function needs a copyable callable, so the task lives behind a shared pointer
+        auto task_ptr = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> result = task_ptr->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.emplace_back([task_ptr]() { (*task_ptr)(); });
+        }
+
+        _job_cv.notify_one();
+
+        return result;
+    }
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> _workers{};
+    std::deque<std::function<void()>> _jobs{};
+
+    std::mutex _mutex;
+    std::condition_variable _job_cv;
+
+    bool _stopping = false;
+};
+
+} // namespace fl
+
+#endif // _FL_THREAD_POOL_H
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef _FL_UNIFORM_RING_H
+#define _FL_UNIFORM_RING_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+
+#include <atomic>
+#include <cstring>
+
+namespace fl {
+
+// the set every pipeline layout reserves for the ring, right after the bindless heap
+const uint32_t UNIFORM_RING_SET = 1;
+
+const uint32_t UNIFORM_RING_UNIFORM_BINDING = 0; // a dynamic uniform buffer
+const uint32_t UNIFORM_RING_STORAGE_BINDING = 1; // a dynamic storage buffer over the same memory
+
+// bytes every frame in flight can allocate
+const VkDeviceSize DEFAULT_UNIFORM_RING_FRAME_SIZE = 1024 * 1024;
+
+// bytes a shader sees behind a dynamic offset, the largest single allocation that can be bound.
+// 16 KiB is the smallest maxUniformBufferRange vulkan guarantees
+const VkDeviceSize DEFAULT_UNIFORM_RING_BINDING_RANGE = 16 * 1024;
+
+/// a sub range handed out by the ring, valid until the frame slot comes around again
+struct UniformAllocation {
+    void    *ptr    = nullptr; // persistently mapped, write the data here
+    uint32_t offset = 0;       // the dynamic offset to bind it with
+};
+
+/// UniformRing is a linear allocator over one persistently mapped buffer with a region per frame in flight.
+/// Per frame and per draw constants cost an atomic bump and a memcpy, they are bound through dynamic offsets
+/// of a single descriptor set that is written once at init and never updated again
+class UniformRing {
+public:
+    UniformRing();
+    ~UniformRing();
+
+    UniformRing(UniformRing&) = delete;
+    UniformRing& operator=(UniformRing&) = delete;
+
+    bool init(VkPhysicalDevice physical, VkDevice logical, GpuAllocator *allocator_ptr, uint32_t frame_count,
+              VkDeviceSize frame_size = DEFAULT_UNIFORM_RING_FRAME_SIZE,
+              VkDeviceSize binding_range = DEFAULT_UNIFORM_RING_BINDING_RANGE);
+
+    void destroy();
+
+    // rewinds the frame's region, only call after the frame's fence signaled
+    void begin_frame(size_t frame_idx);
+
+    // aligned for both uniform and storage use, safe to call from several recording threads at once.
+    // fails once the frame's region is used up or the size exceeds the binding range
+    bool allocate(VkDeviceSize size, UniformAllocation *alloc_ptr);
+
+    template<typename T>
+    bool push(const T &data, uint32_t *offset_ptr) {
+        UniformAllocation alloc{};
+
+        if(allocate(sizeof(T), &alloc) == false)
+            return false;
+
+        memcpy(alloc.ptr, &data, sizeof(T));
+        *offset_ptr = alloc.offset;
+
+        return true;
+    }
+
+    // binds the ring to UNIFORM_RING_SET, any layout from the LayoutCache it was reserved in works
+    void bind(VkCommandBuffer cmd_buf, VkPipelineBindPoint bind_point, VkPipelineLayout layout,
+              uint32_t uniform_offset, uint32_t storage_offset = 0) const;
+
+    VkDescriptorSetLayout get_raw_set_layout_handle() const;
+
+    VkDeviceSize get_frame_used() const; // bytes allocated from the current frame's region
+
+private:
+    VkBuffer      _buf = VK_NULL_HANDLE;
+    GpuAllocation _alloc{};
+
+    VkDescriptorSetLayout _set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool      _pool = VK_NULL_HANDLE;
+    VkDescriptorSet       _set  = VK_NULL_HANDLE;
+
+    VkDeviceSize _frame_size    = 0;
+    VkDeviceSize _frame_base    = 0;
+    VkDeviceSize _binding_range = 0;
+    VkDeviceSize _alignment     = 0;
+
+    std::atomic<VkDeviceSize> _frame_head{0};
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_UNIFORM_RING_H
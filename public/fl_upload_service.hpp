@@ -0,0 +1,113 @@
+#pragma once
+#ifndef _FL_UPLOAD_SERVICE_H
+#define _FL_UPLOAD_SERVICE_H
+
+#include <vulkan/vulkan_core.h>
+
+#include <fl_gpu_allocator.hpp>
+
+#include <vector>
+
+namespace fl {
+
+// size of the host visible ring every upload is staged through
+const VkDeviceSize DEFAULT_STAGING_RING_SIZE = 16ull * 1024 * 1024;
+
+// amount of upload submissions that can be in flight at once
+const uint32_t UPLOAD_SUBMISSION_SLOTS = 4;
+
+// stages of the graphics submit that wait on a flushed upload, covers vertex, index, uniform and indirect reads
+const VkPipelineStageFlags UPLOAD_WAIT_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT  |
+                                                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT   |
+                                                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT  |
+                                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+/// UploadService copies data into device local buffers through a persistently mapped staging ring.
+/// Copies are recorded into the transfer queue, which is a dedicated transfer family when the device has one,
+/// and flush hands back a semaphore so the graphics submit waits on the gpu instead of the cpu blocking
+class UploadService {
+public:
+    UploadService();
+    ~UploadService();
+
+    UploadService(UploadService&) = delete;
+    UploadService& operator=(UploadService&) = delete;
+
+    bool init(VkDevice logical, GpuAllocator *allocator_ptr, uint32_t transfer_family_idx, VkQueue transfer_queue,
+              uint32_t graphics_family_idx, VkDeviceSize ring_size = DEFAULT_STAGING_RING_SIZE);
+
+    // waits for every upload in flight before releasing anything
+    void destroy();
+
+    // resources created afterwards are also accessible from this family, like an async compute one
+    void add_sharing_family(uint32_t family_idx);
+
+    // creates a device local buffer that the transfer, graphics and every added family can access without
+    // ownership transfers
+    bool create_device_local_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                                    VkBuffer *buffer_ptr, GpuAllocation *alloc_ptr);
+
+    // same as the buffer version for a 2d image with a single mip level and layer, TRANSFER_DST is added to the usage
+    bool create_device_local_image(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+                                   VkImage *image_ptr, GpuAllocation *alloc_ptr);
+
+    // stages the data and records the copy, nothing reaches the gpu until flush,
+    // the destination must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    bool upload(VkBuffer dst, VkDeviceSize dst_offset, const void *data, VkDeviceSize size);
+
+    // stages tightly packed texels of the whole image, which has to fit into the staging ring. The image must be
+    // freshly created, it is moved into VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL by the copy
+    bool upload_image(VkImage dst, VkExtent2D extent, const void *data, VkDeviceSize size);
+
+    // submits the recorded copies, the returned semaphore must be waited on with UPLOAD_WAIT_STAGES by the very next
+    // graphics submit. VK_NULL_HANDLE when nothing was recorded since the last flush
+    VkSemaphore flush();
+
+    // blocks until every submitted upload completed, anything still recorded is submitted first
+    void wait_idle();
+
+private:
+    struct Submission {
+        VkCommandBuffer cmd_buf = VK_NULL_HANDLE;
+        VkFence     fence = VK_NULL_HANDLE;
+        VkSemaphore sema  = VK_NULL_HANDLE;
+
+        VkDeviceSize ring_bytes = 0; // staging space held until the fence signals, including wrap around waste
+        bool in_flight = false;
+    };
+
+    bool begin_recording();
+    bool submit_recording(bool signal_sema);
+
+    bool reserve_ring(VkDeviceSize size, VkDeviceSize *offset_ptr);
+
+    void retire_completed();
+    void retire(Submission *submission_ptr);
+
+    std::vector<Submission> _submissions{};
+    size_t _recording_idx = 0; // submissions are reused round robin, so the next one over is always the oldest
+    bool   _recording     = false;
+
+    VkBuffer      _ring_buf = VK_NULL_HANDLE;
+    GpuAllocation _ring_alloc{};
+
+    VkDeviceSize _ring_size = 0;
+    VkDeviceSize _ring_head = 0;
+    VkDeviceSize _ring_used = 0;
+
+    VkCommandPool _cmd_pool = VK_NULL_HANDLE;
+    VkQueue _transfer_queue = VK_NULL_HANDLE;
+
+    uint32_t _transfer_family_idx = 0;
+    uint32_t _graphics_family_idx = 0;
+
+    std::vector<uint32_t> _sharing_families{}; // unique, concurrent sharing once there is more than one
+
+    GpuAllocator *_allocator_ptr = nullptr;
+    VkDevice _logical_device = VK_NULL_HANDLE;
+};
+
+} // namespace fl
+
+#endif // _FL_UPLOAD_SERVICE_H
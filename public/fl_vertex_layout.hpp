@@ -0,0 +1,183 @@
+#pragma once
+#ifndef _FL_VERTEX_LAYOUT_H
+#define _FL_VERTEX_LAYOUT_H
+
+#include <vulkan/vulkan_core.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fl {
+
+/// vertex bindings and attributes a pipeline consumes
+struct VertexInputDesc {
+    std::vector<VkVertexInputBindingDescription>   bindings{};
+    std::vector<VkVertexInputAttributeDescription> attrs{};
+};
+
+// IEEE 754 binary16, rounds to nearest even and keeps infinities and NaNs
+uint16_t pack_half(float value);
+float unpack_half(uint16_t half);
+
+// packed attribute types, each one maps to exactly one VkFormat through VertexFormat below
+
+/// two half floats, R16G16_SFLOAT, good enough for positions in a small range and for uvs
+struct Half2 {
+    uint16_t x = 0;
+    uint16_t y = 0;
+
+    Half2() = default;
+    Half2(float x, float y);
+    Half2(const glm::vec2 &v);
+
+    glm::vec2 unpack() const;
+};
+
+/// four half floats, R16G16B16A16_SFLOAT
+struct Half4 {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint16_t z = 0;
+    uint16_t w = 0;
+
+    Half4() = default;
+    Half4(float x, float y, float z, float w);
+    Half4(const glm::vec4 &v);
+
+    glm::vec4 unpack() const;
+};
+
+/// four bytes mapped to [0, 1], R8G8B8A8_UNORM, red in the lowest byte
+struct Unorm8x4 {
+    uint32_t packed = 0;
+
+    Unorm8x4() = default;
+    Unorm8x4(float r, float g, float b, float a = 1.0f);
+    Unorm8x4(const glm::vec4 &v);
+
+    glm::vec4 unpack() const;
+};
+
+/// two shorts mapped to [-1, 1], R16G16_SNORM, meant for octahedron encoded normals and tangents
+struct Snorm16x2 {
+    int16_t x = 0;
+    int16_t y = 0;
+
+    Snorm16x2() = default;
+    Snorm16x2(float x, float y);
+    Snorm16x2(const glm::vec2 &v);
+
+    glm::vec2 unpack() const;
+};
+
+// maps an attribute type to the format the input assembler reads it with
+template<typename T>
+struct VertexFormat;
+
+template<> struct VertexFormat<float>     { static constexpr VkFormat value = VK_FORMAT_R32_SFLOAT; };
+template<> struct VertexFormat<glm::vec2> { static constexpr VkFormat value = VK_FORMAT_R32G32_SFLOAT; };
+template<> struct VertexFormat<glm::vec3> { static constexpr VkFormat value = VK_FORMAT_R32G32B32_SFLOAT; };
+template<> struct VertexFormat<glm::vec4> { static constexpr VkFormat value = VK_FORMAT_R32G32B32A32_SFLOAT; };
+template<> struct VertexFormat<uint32_t>  { static constexpr VkFormat value = VK_FORMAT_R32_UINT; };
+template<> struct VertexFormat<Half2>     { static constexpr VkFormat value = VK_FORMAT_R16G16_SFLOAT; };
+template<> struct VertexFormat<Half4>     { static constexpr VkFormat value = VK_FORMAT_R16G16B16A16_SFLOAT; };
+template<> struct VertexFormat<Unorm8x4>  { static constexpr VkFormat value = VK_FORMAT_R8G8B8A8_UNORM; };
+template<> struct VertexFormat<Snorm16x2> { static constexpr VkFormat value = VK_FORMAT_R16G16_SNORM; };
+
+// bytes one element of the format occupies, 0 for formats the layouts do not know
+constexpr uint32_t get_vertex_format_size(VkFormat format) {
+    switch(format) {
+        case VK_FORMAT_R32_SFLOAT:          return 4;
+        case VK_FORMAT_R32_UINT:            return 4;
+        case VK_FORMAT_R32G32_SFLOAT:       return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT:    return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+        case VK_FORMAT_R16G16_SFLOAT:       return 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+        case VK_FORMAT_R8G8B8A8_UNORM:      return 4;
+        case VK_FORMAT_R16G16_SNORM:        return 4;
+        default:                            return 0;
+    }
+}
+
+/// one attribute of a vertex, the format defaults to the one of its type but can be overridden,
+/// e.g. to read a plain uint32_t as R8G8B8A8_UNORM
+template<typename T, uint32_t Offset, VkFormat Format = VertexFormat<T>::value>
+struct VertexAttr {
+    using Type = T;
+
+    static constexpr uint32_t offset = Offset;
+    static constexpr VkFormat format = Format;
+
+    static_assert(get_vertex_format_size(Format) == sizeof(T), "vertex attribute format does not match its type");
+};
+
+// the attribute for a member, offsetof keeps the offset a compile time constant
+#define FL_VERTEX_ATTR(vertex_type, member) \
+    ::fl::VertexAttr<decltype(vertex_type::member), offsetof(vertex_type, member)>
+
+#define FL_VERTEX_ATTR_AS(vertex_type, member, format) \
+    ::fl::VertexAttr<decltype(vertex_type::member), offsetof(vertex_type, member), format>
+
+/// VertexLayout derives the binding and attribute descriptions of a vertex type from its attribute list,
+/// locations follow the list order. Every attribute is checked against the vertex at compile time,
+/// so a table can no longer disagree with the struct it describes
+template<typename VertexT, typename... Attrs>
+struct VertexLayout {
+    static constexpr uint32_t attr_count = sizeof...(Attrs);
+    static constexpr uint32_t stride     = sizeof(VertexT);
+
+    static_assert(attr_count > 0, "a vertex layout needs at least one attribute");
+    static_assert(((Attrs::offset + sizeof(typename Attrs::Type) <= stride) && ...),
+                  "vertex attribute lies outside of the vertex");
+
+    static constexpr VkVertexInputBindingDescription get_binding_desc(
+            uint32_t binding = 0, VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX) {
+        VkVertexInputBindingDescription desc{};
+
+        desc.binding   = binding;
+        desc.stride    = stride;
+        desc.inputRate = input_rate;
+
+        return desc;
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, attr_count> get_attr_descs(
+            uint32_t binding = 0, uint32_t first_location = 0) {
+        std::array<VkVertexInputAttributeDescription, attr_count> descs{};
+
+        uint32_t location = first_location;
+        size_t i = 0;
+
+        ((descs[i++] = make_attr_desc<Attrs>(binding, location++)), ...);
+
+        return descs;
+    }
+
+    static VertexInputDesc get_input_desc(uint32_t binding = 0,
+                                          VkVertexInputRate input_rate = VK_VERTEX_INPUT_RATE_VERTEX) {
+        auto attr_descs = get_attr_descs(binding);
+
+        return VertexInputDesc{ { get_binding_desc(binding, input_rate) }, { attr_descs.begin(), attr_descs.end() } };
+    }
+
+private:
+    template<typename Attr>
+    static constexpr VkVertexInputAttributeDescription make_attr_desc(uint32_t binding, uint32_t location) {
+        VkVertexInputAttributeDescription desc{};
+
+        desc.binding  = binding;
+        desc.location = location;
+        desc.format   = Attr::format;
+        desc.offset   = Attr::offset;
+
+        return desc;
+    }
+};
+
+} // namespace fl
+
+#endif // _FL_VERTEX_LAYOUT_H
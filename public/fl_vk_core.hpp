@@ -5,6 +5,8 @@
 #include <fl_vk_device_manager.hpp>
 #include <fl_vk_instance.hpp>
 #include <fl_swapchain.hpp>
+#include <fl_offscreen_target.hpp>
+#include <fl_gpu_allocator.hpp>
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
@@ -17,8 +19,47 @@ namespace fl {
 
 struct QueueFamilyIdxs {
     std::optional<uint32_t> graphics, present;
+
+    // a family with transfer but neither graphics nor compute, usually backed by a dma engine
+    std::optional<uint32_t> transfer;
+
+    // a family with compute but no graphics, its queue runs alongside the graphics one
+    std::optional<uint32_t> compute;
+};
+
+/// optional device capabilities, only turned on when both the instance and the device support them
+struct DeviceFeatures {
+    uint32_t api_version = VK_API_VERSION_1_0; // what the instance and device agreed on
+
+    // runtime sized descriptor arrays, indexed non uniformly, partially bound and updated after binding
+    bool descriptor_indexing = false;
+
+    // several indirect draws per call, without it every indirect draw costs a call of its own
+    bool multi_draw_indirect = false;
+
+    // vkCmdDrawIndexedIndirectCountKHR, the draw count is read from a buffer the gpu wrote
+    bool draw_indirect_count = false;
+
+    // semaphores with a 64 bit counter, waited on by the cpu and signaled once per submit instead of fences
+    bool timeline_semaphore = false;
+
+    // VK_KHR_dynamic_rendering, render pass instances begin on image views without render pass or frame buffer objects
+    bool dynamic_rendering = false;
+};
+
+/// how frames reach the screen, unsupported modes fall back towards FIFO which every surface has
+enum class PresentPolicy {
+    FIFO,         // waits for vblank, frames are never dropped and the cpu is throttled to the refresh rate
+    FIFO_RELAXED, // like FIFO, but a late frame is shown right away and may tear
+    MAILBOX,      // waits for vblank, but a newer frame replaces the queued one so rendering is never throttled
+    IMMEDIATE     // shown right away and may tear, the lowest latency
 };
 
+// spelled like the benchmark's --present-mode values
+const char* get_present_mode_name(VkPresentModeKHR present_mode);
+
+// the newest vulkan version the engine asks for, older loaders and devices are still accepted
+const uint32_t MAX_API_VERSION = VK_API_VERSION_1_2;
 
 class VkCore {
 public:
@@ -30,19 +71,50 @@ public:
 
     bool init(std::string app_name, GLFWwindow *window_ptr);
 
+    // initializes without glfw, a surface or VK_KHR_swapchain, rendering into offscreen images instead
+    bool init_headless(std::string app_name, VkExtent2D extent, uint32_t img_count);
+
+    bool is_headless() const;
+
+    // swap chain images to ask for, clamped to the surface limits. 0 asks for one above the surface minimum so the
+    // cpu never waits on the presentation engine to release an image, must be set before init
+    void set_swap_chain_img_count(uint32_t count);
+
+    // applies to every swap chain created afterwards, MAILBOX by default
+    void set_present_policy(PresentPolicy policy);
+
+    // the mode the current swap chain was created with
+    VkPresentModeKHR get_present_mode() const;
+
     VkDeviceManager* get_device_manager_ptr();
     Swapchain* get_swap_chain_ptr();
+    OffscreenTarget* get_offscreen_target_ptr();
+    GpuAllocator* get_allocator_ptr();
 
     VkFormat get_chosen_img_format() const;
     VkExtent2D get_swap_chain_extent() const;
     const QueueFamilyIdxs* get_queue_family_idxs_ptr() const;
+    const DeviceFeatures* get_device_features_ptr() const;
 
     VkQueue& get_graphics_queue_ref();
     VkQueue& get_present_queue_ref();
 
-    bool recreate_swap_chain(GLFWwindow *window_ptr);
+    // the dedicated transfer queue when the device has one, the graphics queue otherwise
+    VkQueue& get_transfer_queue_ref();
+    uint32_t get_transfer_queue_family() const;
+
+    // the async compute queue when the device has a compute only family, the graphics queue otherwise
+    VkQueue& get_compute_queue_ref();
+    uint32_t get_compute_queue_family() const;
+    bool has_async_compute() const;
+
+    // builds the new swap chain from the old one without waiting for the device. The old one is retired and
+    // handed back through old_swap_chain_ptr, the caller destroys it once no frame in flight uses its images
+    bool recreate_swap_chain(GLFWwindow *window_ptr, VkSwapchainKHR *old_swap_chain_ptr);
 
 private:
+    bool setup_device();
+
     bool setup_instance(std::string app_name);
 
     void setup_debug_messenger();
@@ -57,9 +129,12 @@ private:
 
     bool setup_logical_device(VkPhysicalDevice physical_device, VkDevice *logical_device_ptr);
 
+    // fills _device_features with what the device supports and appends the extensions it needs
+    void query_device_features(VkPhysicalDevice physical_device, std::vector<const char*> *extensions_ptr);
+
     bool find_queue_families(VkPhysicalDevice physical_device, QueueFamilyIdxs *idxs_ptr);
 
-    bool create_swap_chain(GLFWwindow *window_ptr);
+    bool create_swap_chain(GLFWwindow *window_ptr, VkSwapchainKHR old_swap_chain = VK_NULL_HANDLE);
 
     void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT *info_ptr);
 
@@ -67,24 +142,38 @@ private:
 
     Instance _instance;
 
-    VkSurfaceKHR _surface;
+    VkSurfaceKHR _surface = VK_NULL_HANDLE;
     Swapchain _swap_chain;
 
+    OffscreenTarget _offscreen_target;
+    bool _headless = false;
+
+    uint32_t _desired_img_count = 0;
+
+    PresentPolicy    _present_policy = PresentPolicy::MAILBOX;
+    VkPresentModeKHR _present_mode   = VK_PRESENT_MODE_FIFO_KHR;
+
     VkFormat _chosen_img_format;
     VkExtent2D _chosen_extent;
 
-    VkDeviceManager *_device_manager_ptr;
+    VkDeviceManager *_device_manager_ptr = nullptr;
+
+    GpuAllocator _allocator;
 
     VkDevice _logical_device  = VK_NULL_HANDLE;
 
     QueueFamilyIdxs _queue_family_idxs;
+    DeviceFeatures  _device_features;
+
+    uint32_t _instance_api_version = VK_API_VERSION_1_0;
 
     VkQueue _graphics_queue;
     VkQueue _present_queue;
+    VkQueue _transfer_queue;
+    VkQueue _compute_queue;
 
-    const std::vector<const char*> _device_req_extensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    // filled in on init, headless devices do not need VK_KHR_swapchain
+    std::vector<const char*> _device_req_extensions{};
 
 
     bool _enable_debug;
@@ -98,7 +187,7 @@ private:
         VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
         VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
 
-    VkDebugUtilsMessengerEXT _debug_messenger;
+    VkDebugUtilsMessengerEXT _debug_messenger = VK_NULL_HANDLE;
 };
 
 } // namespace fl
@@ -35,6 +35,9 @@ bool is_physical_surface_supported(VkPhysicalDevice device, uint32_t queue_idx,
 
 uint32_t get_physical_queue_family_props(VkPhysicalDevice device, std::vector<VkQueueFamilyProperties> *props_ptr);
 
+/// the most precise depth only format the device can render into with optimal tiling
+bool find_depth_format(VkPhysicalDevice device, VkFormat *format_ptr);
+
 } // namespace fl
 
 #endif // _FL_VULKAN_UTILS_H